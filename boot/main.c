@@ -27,12 +27,17 @@
  *    and a stack so C code then run, then calls cmain()
  *
  *  * cmain() in this file takes over, reads in the kernel and jumps to it.
+ *
+ *  * 2026: each segment is read in multi-sector commands (of at most
+ *    MAXSECTS sectors), and only its part in the file: the rest (.bss)
+ *    is cleared by the kernel itself (see FOS_initialize()).
  **********************************************************************/
 
 #define SECTSIZE	512
+#define MAXSECTS	128		// max # sectors per read command
 #define ELFHDR		((struct Elf *) 0x10000) // scratch space
 
-void readsect(void*, uint32);
+void readsects(uint8*, uint32, uint32);
 void readseg(uint32, uint32, uint32);
 
 void
@@ -48,10 +53,11 @@ cmain(void)
 		goto bad;
 
 	// load each program segment (ignores ph flags)
+	// (2026: its file part only, nothing for the .bss)
 	ph = (struct Proghdr *) ((uint8 *) ELFHDR + ELFHDR->e_phoff);
 	eph = ph + ELFHDR->e_phnum;
 	for (; ph < eph; ph++)
-		readseg(ph->p_va, ph->p_memsz, ph->p_offset);
+		readseg(ph->p_va, ph->p_filesz, ph->p_offset);
 
 	// call the entry point from the ELF header
 	// note: does not return!
@@ -80,13 +86,16 @@ readseg(uint32 va, uint32 count, uint32 offset)
 	// translate from bytes to sectors, and kernel starts at sector 1
 	offset = (offset / SECTSIZE) + 1;
 
-	// If this is too slow, we could read lots of sectors at a time.
-	// We'd write more to memory than asked, but it doesn't matter --
+	// 2026: read lots of sectors at a time.
+	// We write more to memory than asked, but it doesn't matter --
 	// we load in increasing order.
 	while (va < end_va) {
-		readsect((uint8*) va, offset);
-		va += SECTSIZE;
-		offset++;
+		uint32 nsecs = (end_va - va + SECTSIZE - 1) / SECTSIZE;
+		if (nsecs > MAXSECTS)
+			nsecs = MAXSECTS;
+		readsects((uint8*) va, offset, nsecs);
+		va += nsecs * SECTSIZE;
+		offset += nsecs;
 	}
 }
 
@@ -98,23 +107,26 @@ waitdisk(void)
 		/* do nothing */;
 }
 
+// 2026: reads 'nsecs' (<= MAXSECTS) sectors in a single command
 void
-readsect(void *dst, uint32 offset)
+readsects(uint8 *dst, uint32 offset, uint32 nsecs)
 {
 	// wait for disk to be ready
 	waitdisk();
 
-	outb(0x1F2, 1);		// count = 1
+	outb(0x1F2, nsecs);	// count
 	outb(0x1F3, offset);
 	outb(0x1F4, offset >> 8);
 	outb(0x1F5, offset >> 16);
 	outb(0x1F6, (offset >> 24) | 0xE0);
 	outb(0x1F7, 0x20);	// cmd 0x20 - read sectors
 
-	// wait for disk to be ready
-	waitdisk();
-
-	// read a sector
-	insl(0x1F0, dst, SECTSIZE/4);
+	// read each sector once the disk has it ready: not busy AND requesting the transfer (DRQ),
+	// it can be not busy before it's ready to transfer the next sector
+	for (; nsecs > 0; nsecs--, dst += SECTSIZE) {
+		while ((inb(0x1F7) & 0x88) != 0x08)
+			/* do nothing */;
+		insl(0x1F0, dst, SECTSIZE/4);
+	}
 }
 
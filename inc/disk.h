@@ -20,4 +20,48 @@
 //void	ide_set_disk(int diskno);
 int	ide_read(uint32 secno, void *dst, uint32 nsecs);
 int	ide_write(uint32 secno, const void *src, uint32 nsecs);
+
+//2026: transfers on a given disk (0, 1: primary master/slave, 2, 3: secondary master/slave)
+#define IDE_MAX_DISKS	4
+#define IDE_CHANNEL(disk)	((disk) >> 1)
+struct IdeTransfer
+{
+	uint32 disk;
+	uint32 secno;
+	uint32 nsecs;
+	uint8* buf;
+	uint8 isWrite;
+};
+int	ide_read_disk(uint32 disk, uint32 secno, void *dst, uint32 nsecs);
+int	ide_write_disk(uint32 disk, uint32 secno, const void *src, uint32 nsecs);
+int ide_disk_present(uint32 disk);
+
+//2026: 48-bit LBA (disks beyond 128 GB, up to 65536 sectors per command)
+#define IDE_LBA28_MAX_SECTOR	(1 << 28)	//# sectors addressable by the 28-bit LBA commands
+#define IDE_LBA28_MAX_SECTS		256			//max # sectors of a 28-bit LBA command
+#define IDE_LBA48_MAX_SECTS		65536		//max # sectors of a 48-bit LBA command
+#define IDE_IDENTIFY_TIMEOUT	1000000
+int ide_identify(uint32 disk, uint32* nsectors);
+uint32 ide_max_sectors(uint32 disk);
+int ide_transfer(struct IdeTransfer* t);
+int ide_transfer_pair(struct IdeTransfer* a, struct IdeTransfer* b);
+
+//2026: bus-master DMA (falls back to PIO when no controller is found)
+extern uint32 ide_dma_enabled;
+#define IDE_DMA_BOUNCE_SECTS	128		//64 KB: a single PRD that never crosses a 64 KB boundary
+int ide_dma_init();
+uint32 ide_dma_set(uint32 enable);
+
+//2026: asynchronous DMA read (completion signaled on IRQ14)
+#define IDE_ASYNC_MAX_SECTS	8		//one page
+#define IDE_ASYNC_IDLE		0
+#define IDE_ASYNC_BUSY		1
+#define IDE_ASYNC_DONE		2		//completed, data not collected yet
+#define IDE_ASYNC_ERROR		3
+#define IDE_IRQ				14
+
+extern uint32 ide_async_state;
+int ide_read_async(uint32 secno, uint32 nsecs);
+uint32 ide_async_poll(bool wait);
+int ide_async_collect(void *dst);
 #endif	// !DISK_H
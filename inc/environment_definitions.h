@@ -47,8 +47,15 @@ unsigned int _ModifiedBufferLength;
 #define ENV_NEW			4
 #define ENV_EXIT		5
 #define ENV_UNKNOWN		6
+#define ENV_SUSPENDED	7
 
 
+//2026: max # ranges with a sequential/random access advice per env (see sys_madvise)
+#define MAX_MEM_ADVICES 8
+
+//2026: max # program segments of a lazily loaded env (see env_create)
+#define MAX_LAZY_SEGMENTS 8
+
 uint32 old_pf_counter;
 //uint32 mydblchk;
 struct WorkingSetElement {
@@ -60,6 +67,22 @@ struct WorkingSetElement {
 };
 
 
+//2026
+struct MemAdvice {
+	uint32 start;
+	uint32 end;
+	uint32 advice;		// MADV_SEQUENTIAL or MADV_RANDOM (0 means empty entry)
+};
+
+//2026: program segment whose pages are loaded on their first fault
+struct LazySegment {
+	uint32 start;		// va of the segment
+	uint32 fileEnd;		// end va of its part in the program file (zeros from here to memEnd)
+	uint32 memEnd;
+	uint8* src;			// address of the segment in the program image
+	uint8 readOnly;		// not writable (its pages can be shared between the instances of the program)
+};
+
 struct Env {
 	struct Trapframe env_tf;	// Saved registers
 	LIST_ENTRY(Env) prev_next_info;	// Free list link pointers
@@ -112,6 +135,66 @@ struct Env {
 
 	uint32 nClocks ;
 
+	//2026: load control
+	int priority;				// PRIORITY_LOW ... PRIORITY_HIGH
+	uint32 nSuspensions;		// # times swapped out by the load controller
+	uint32 suspendedWSSize;		// # resident pages at the last suspension
+
+	//2026: priority classes (see set_program_priority())
+	uint8 isWSDoubled;			// its WS was already doubled for its priority
+
+	//2026: the scheduler queue it's in (SCHQ_*, see kern/sched.h), at schedLevel for a ready queue
+	uint8 schedQueue;
+
+	//2026: wait for the children
+	int32 waitEnvId;			// the child it waits for in sys_waitenv() (or ANY_CHILD)
+	int exitStatus;
+
+	//2026: WS prewarming
+	struct ProgramProfile* ptr_profile;	// fault profile being recorded (NULL if not recording)
+
+	//2026: memory hints
+	struct MemAdvice memAdvices[MAX_MEM_ADVICES];
+	uint32 nLockedPages;		// # pages pinned by sys_mlock
+
+	//2026: non-blocking page faults
+	uint32 pendingPageInVA;		// page being read from the page file while the env is BLOCKED (0 if none)
+
+	//2026: lazy program loading
+	struct LazySegment lazySegments[MAX_LAZY_SEGMENTS];
+	uint32 nLazySegments;		// 0 if the program was loaded at creation
+
+	//2026: shared program text
+	struct SharedImage* ptr_shared_image;	// shared frames of the read-only pages of the program (NULL if not shared)
+
+	//2026: MLFQ
+	uint8 schedLevel;			// level of its ready queue (0 is the highest)
+
+	//2026: sys_sleep
+	uint32 wakeupTime;			// time (sched_time_ms) to wake it up while it's sleeping in the timer wheel
+
+	//2026: CPU accounting (in ns, see kclock_now_ns())
+	uint64 runTime;				// time running in user mode
+	uint64 waitTime;			// time waiting in the ready queues
+	uint64 maxWaitTime;			// longest wait in the ready queues
+	uint32 nSwitches;			// # context switches to it
+	uint64 lastTimestamp;		// when it was last made ready / resumed in user mode
+
+	//2026: CFS
+	uint64 vruntime;			// weighted virtual run time (ns)
+	struct Env* cfsLeft;		// its children in the CFS tree (while it's ready)
+	struct Env* cfsRight;
+	uint8 cfsHeight;
+
+	//2026: EDF (deadline class, dlPeriod = 0 if not in it)
+	uint32 dlRuntime;			// budget in each period (ms)
+	uint32 dlPeriod;			// (ms)
+	uint64 dlDeadline;			// end of the current period (ns)
+	int64 dlBudget;				// remaining budget in the current period (ns)
+	uint8 dlThrottled;			// sleeping till the end of its period after using up its budget
+	uint32 dlPeriods;			// # periods started
+	uint32 dlMissed;			// # deadlines reached with budget left
+	uint32 dlThrottles;			// # times it used up its budget
 
 };
 #define PRIORITY_LOW    		1
@@ -120,9 +203,26 @@ struct Env {
 #define PRIORITY_ABOVENORMAL    4
 #define PRIORITY_HIGH		    5
 
-#define LOG2NENV		10
-//#define NENV			(1 << LOG2NENV)
-#define NENV			( (PTSIZE/4) / sizeof(struct Env) )
+//2026: NENV should be a power of 2 for ENVX() (envid2env() finds an env by its slot in O(1)),
+//and the envs array should fit in PTSIZE/4 (checked in initialize_kernel_VM())
+#define LOG2NENV		9
+#define NENV			(1 << LOG2NENV)
+//#define NENV			( (PTSIZE/4) / sizeof(struct Env) )
 #define ENVX(envid)		((envid) & (NENV - 1))
 
+//2026: sys_waitenv() on any child of the caller
+#define ANY_CHILD		(-1)
+
+//2026: what sys_waitenv() collects from an exited child
+struct EnvExitInfo
+{
+	int32 envId;
+	int exitStatus;				// given to sys_env_exit_status() (0 for exit())
+	uint32 pageFaults;
+	uint32 tableFaults;
+	uint32 nClocks;
+	uint64 runTime;				// (ns)
+	uint64 waitTime;			// in the ready queues (ns)
+};
+
 #endif // !FOS_INC_ENV_H
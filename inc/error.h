@@ -26,6 +26,7 @@
 #define E_ENV_CREATION_ERROR	-17
 
 #define E_NO_VM -20	// No free space in page file for new pages
+#define E_NO_BANDWIDTH -21	// The CPU utilization of the deadline envs would exceed its limit
 
 #define	MAXERROR	100
 
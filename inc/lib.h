@@ -42,6 +42,7 @@ int32	sys_getenvid(void);
 int32	sys_getparentenvid(void);
 int		sys_env_destroy(int32);
 void 	sys_env_exit();
+void 	sys_env_exit_status(int status);
 int 	__sys_allocate_page(void *va, int perm);
 int 	__sys_map_frame(int32 srcenv, void *srcva, int32 dstenv, void *dstva, int perm);
 int 	__sys_unmap_frame(int32 envid, void *va);
@@ -99,6 +100,15 @@ uint32 sys_isUHeapPlacementStrategyWORSTFIT();
 
 void sys_set_uheap_strategy(uint32 heapStrategy);
 
+int sys_madvise(uint32 virtual_address, uint32 size, int advice);
+int sys_mlock(uint32 virtual_address, uint32 size);
+int sys_munlock(uint32 virtual_address, uint32 size);
+void sys_sleep(uint32 milliseconds);
+void sys_yield();
+int sys_set_deadline(uint32 runtime, uint32 period);
+int sys_set_priority(int32 envId, int priority);
+int sys_waitenv(int32 envId, struct EnvExitInfo* info);
+
 struct uint64 sys_get_virtual_time();
 
 // console.c
@@ -151,6 +151,9 @@
 #define KERNEL_HEAP_START 0xF6000000
 #define KERNEL_HEAP_MAX 0xFFFFF000
 
+//2026: the local APIC registers are mapped at the last page (above the kernel heap)
+#define LAPIC_VA KERNEL_HEAP_MAX
+
 #define USER_HEAP_START 0x80000000
 #define USER_HEAP_MAX 0xA0000000
 
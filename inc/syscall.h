@@ -50,6 +50,14 @@ enum
 	SYS_gettst,
 	SYS_get_heap_strategy,
 	SYS_set_heap_strategy,
+	SYS_madvise,
+	SYS_mlock,
+	SYS_munlock,
+	SYS_sleep,
+	SYS_yield,
+	SYS_set_deadline,
+	SYS_set_priority,
+	SYS_waitenv,
 	NSYSCALLS
 };
 
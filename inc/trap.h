@@ -30,6 +30,8 @@
 // These are arbitrarily chosen, but with care not to overlap
 // processor defined exceptions or interrupt vectors.
 #define T_SYSCALL   48		// system call
+#define T_LAPIC_TIMER		49	// 2026: local APIC timer
+#define T_LAPIC_SPURIOUS	63	// 2026: local APIC spurious interrupt
 #define T_DEFAULT   500		// catchall
 
 #ifndef __ASSEMBLER__
@@ -7,6 +7,13 @@
 #define UHP_PLACE_NEXTFIT 	0x3
 #define UHP_PLACE_WORSTFIT 	0x4
 
+//Values of the memory access advice (see madvise())
+#define MADV_NORMAL			0x0		//no special treatment
+#define MADV_SEQUENTIAL		0x1		//expect sequential access: read ahead on faults
+#define MADV_RANDOM			0x2		//expect random access: no read ahead
+#define MADV_WILLNEED		0x3		//load the range into the WS now (in one batch)
+#define MADV_DONTNEED		0x4		//remove the range from the WS now
+
 
 void *malloc(uint32 size);
 void* smalloc(char *sharedVarName, uint32 size, uint8 isWritable);
@@ -15,4 +22,8 @@ void free(void* virtual_address);
 void sfree(void* virtual_address);
 void *realloc(void *virtual_address, uint32 new_size);
 
+int madvise(void* virtual_address, uint32 size, int advice);
+int mlock(void* virtual_address, uint32 size);
+int munlock(void* virtual_address, uint32 size);
+
 #endif
@@ -39,6 +39,13 @@ static __inline uint32 read_ebp(void) __attribute__((always_inline));
 static __inline uint32 read_esp(void) __attribute__((always_inline));
 static __inline void cpuid(uint32 info, uint32 *eaxp, uint32 *ebxp, uint32 *ecxp, uint32 *edxp);
 static __inline uint64 read_tsc(void) __attribute__((always_inline));
+static __inline uint64 rdmsr(uint32 msr) __attribute__((always_inline));
+static __inline void wrmsr(uint32 msr, uint64 val) __attribute__((always_inline));
+
+//2026: model-specific registers of the SYSENTER/SYSEXIT fast system calls
+#define MSR_IA32_SYSENTER_CS	0x174
+#define MSR_IA32_SYSENTER_ESP	0x175
+#define MSR_IA32_SYSENTER_EIP	0x176
 
 static __inline void
 breakpoint(void)
@@ -289,4 +296,18 @@ read_tsc(void)
         return tsc;
 }
 
+static __inline uint64
+rdmsr(uint32 msr)
+{
+	uint64 val;
+	__asm __volatile("rdmsr" : "=A" (val) : "c" (msr));
+	return val;
+}
+
+static __inline void
+wrmsr(uint32 msr, uint64 val)
+{
+	__asm __volatile("wrmsr" : : "c" (msr), "A" (val));
+}
+
 #endif /* !FOS_INC_X86_H */
@@ -25,10 +25,13 @@ FUNCTIONS:	readline, cprintf, execute_command, run_command_prompt, command_kerne
 #include <kern/kdebug.h>
 #include <kern/user_environment.h>
 #include <kern/file_manager.h>
+#include <kern/disk_queue.h>
+#include <kern/program_store.h>
 #include <kern/sched.h>
 #include <kern/kheap.h>
 #include <kern/utilities.h>
 #include <kern/priority_manager.h>
+#include <kern/pgtrace.h>
 
 //Structure for each command
 struct Command
@@ -104,9 +107,29 @@ int command_test_three_creation_functions(int number_of_arguments, char **argume
 //2018
 int command_sch_RR(int number_of_arguments, char **arguments);
 int command_sch_MLFQ(int number_of_arguments, char **arguments);
+int command_sch_CFS(int number_of_arguments, char **arguments);
 int command_print_sch_method(int number_of_arguments, char **arguments);
 int command_sch_test(int number_of_arguments, char **arguments);
 
+//2026
+int command_load_control(int number_of_arguments, char **arguments);
+int command_print_load_control(int number_of_arguments, char **arguments);
+int command_ws_profiling(int number_of_arguments, char **arguments);
+int command_ws_profile_clear(int number_of_arguments, char **arguments);
+int command_page_trace(int number_of_arguments, char **arguments);
+int command_page_trace_dump(int number_of_arguments, char **arguments);
+int command_ide_dma(int number_of_arguments, char **arguments);
+int command_async_page_in(int number_of_arguments, char **arguments);
+int command_print_disk_queues(int number_of_arguments, char **arguments);
+int command_reset_disk_queues(int number_of_arguments, char **arguments);
+int command_page_file_stripe(int number_of_arguments, char **arguments);
+int command_page_file_header(int number_of_arguments, char **arguments);
+int command_lazy_loading(int number_of_arguments, char **arguments);
+int command_shared_text(int number_of_arguments, char **arguments);
+int command_print_program_store(int number_of_arguments, char **arguments);
+int command_sched_stats(int number_of_arguments, char **arguments);
+int command_set_priority(int number_of_arguments, char **arguments);
+
 
 int command_test_priority1(int number_of_arguments, char **arguments);
 int command_test_priority2(int number_of_arguments, char **arguments);
@@ -128,8 +151,26 @@ struct Command commands[] =
 
 		{ "schedMLFQ", "switch the scheduler to MLFQ with given # queues & quantums", command_sch_MLFQ},
 		{ "schedRR", "switch the scheduler to RR with given quantum", command_sch_RR},
+		{ "schedCFS", "switch the scheduler to the completely fair one [target latency in ms]", command_sch_CFS},
 		{"sched?", "print current scheduler algorithm", command_print_sch_method},
 		{"schedTest", "Used for turning on/off the scheduler test", command_sch_test},
+		{"schedstat", "print the run & wait times of the envs and the run-queue latency histogram [reset]", command_sched_stats},
+		{"priority", "set the priority (1: low ... 5: high) of the given env ID, for its CPU share & WS size", command_set_priority},
+		{"loadctl", "turn on/off the thrashing load control [faults per tick] [low free frames]", command_load_control},
+		{"loadctl?", "print the load control status and the suspended envs", command_print_load_control},
+		{"wsprofile", "turn on/off recording & prewarming the WS from the per-program fault profiles", command_ws_profiling},
+		{"wsprofileclr", "clear the recorded fault profile of the given program", command_ws_profile_clear},
+		{"pgtrace", "start/stop tracing the page references of all envs [or the given env ID only]", command_page_trace},
+		{"pgtracedump", "write the page reference trace to the serial port [of the given env ID only]", command_page_trace_dump},
+		{"idedma", "turn on/off the bus-master DMA transfers of the disk (PIO otherwise)", command_ide_dma},
+		{"asyncpf", "turn on/off the non-blocking page faults (the faulted env waits for its page-in while others run)", command_async_page_in},
+		{"diskq?", "print the depth & merge counters of the disk request queues", command_print_disk_queues},
+		{"diskqclr", "reset the counters of the disk request queues", command_reset_disk_queues},
+		{"pfstripe", "stripe the page file over 1 or 2 disks [IDE disk # of the 2nd one] (no env should be loaded)", command_page_file_stripe},
+		{"pfheader", "write the page file header <size in MB> [start sector] (0 removes it), used at the next boot", command_page_file_header},
+		{"lazyload", "turn on/off loading the programs lazily (each page on its first fault) from their image", command_lazy_loading},
+		{"sharetext", "turn on/off sharing the read-only text frames between the instances of a (lazily loaded) program", command_shared_text},
+		{"progstore?", "print the index of the user programs stored on the disk (runnable by their name)", command_print_program_store},
 
 		{ "run", "runs a single user program", command_run_program },
 		{"load", "load a single user program to mem with status = NEW", commnad_load_env},
@@ -833,6 +874,22 @@ int command_sch_MLFQ(int number_of_arguments, char **arguments)
 	cprintf("\n");
 	return 0;
 }
+int command_sch_CFS(int number_of_arguments, char **arguments)
+{
+	int latency = CFS_DEFAULT_LATENCY_MS;
+	if (number_of_arguments > 1)
+		latency = strtol(arguments[1], NULL, 10);
+	//(the latency is also the quantum of a lone env)
+	if (latency < 1 || latency > kclock_max_interval_ms())
+	{
+		cprintf("invalid target latency: should be in [1, %d] ms\n", kclock_max_interval_ms());
+		return 0;
+	}
+
+	sched_init_CFS(latency);
+	cprintf("Scheduler is now set to CFS with target latency %d ms\n", cfs_latency_ms);
+	return 0;
+}
 int command_print_sch_method(int number_of_arguments, char **arguments)
 {
 	if (isSchedMethodMLFQ())
@@ -848,6 +905,10 @@ int command_print_sch_method(int number_of_arguments, char **arguments)
 	{
 		cprintf("Current scheduler method is Round Robin with quantum %d ms\n", quantums[0]);
 	}
+	else if (isSchedMethodCFS())
+	{
+		cprintf("Current scheduler method is CFS with target latency %d ms\n", cfs_latency_ms);
+	}
 
 	else
 		cprintf("Current scheduler method is UNDEFINED\n");
@@ -865,6 +926,238 @@ int command_sch_test(int number_of_arguments, char **arguments)
 	return 0;
 }
 
+
+/*2026*/
+int command_load_control(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: loadctl <0|1> [faults per tick] [low free frames]\n");
+		return 0;
+	}
+	uint8 status = strtol(arguments[1], NULL, 10);
+	uint32 faultsPerTick = LC_DEFAULT_FAULTS_PER_TICK;
+	uint32 lowFreeFrames = LC_DEFAULT_LOW_FREE_FRAMES;
+	if (number_of_arguments > 2)
+		faultsPerTick = strtol(arguments[2], NULL, 10);
+	if (number_of_arguments > 3)
+		lowFreeFrames = strtol(arguments[3], NULL, 10);
+
+	sched_init_load_control(status, faultsPerTick, lowFreeFrames);
+	if (load_control_status == LC_OFF)
+		cprintf("Load control is TURNED OFF\n");
+	else
+		cprintf("Load control is TURNED ON: suspend when > %d faults/tick and < %d free frames\n", lc_faults_per_tick, lc_low_free_frames);
+	return 0;
+}
+int command_print_load_control(int number_of_arguments, char **arguments)
+{
+	if (load_control_status == LC_OFF)
+		cprintf("Load control is OFF\n");
+	else
+		cprintf("Load control is ON: suspend when > %d faults/tick and < %d free frames\n", lc_faults_per_tick, lc_low_free_frames);
+
+	struct Env* ptr_env ;
+	LIST_FOREACH(ptr_env, &env_suspended_queue)
+	{
+		cprintf("	[%d] %s: suspended %d time(s), %d pages swapped out\n", ptr_env->env_id, ptr_env->prog_name, ptr_env->nSuspensions, ptr_env->suspendedWSSize);
+	}
+	return 0;
+}
+int command_ws_profiling(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: wsprofile <0|1>\n");
+		return 0;
+	}
+	int status = strtol(arguments[1], NULL, 10);
+	enableWSProfiling(status);
+	if (status == 0)
+		cprintf("WS profiling & prewarming is TURNED OFF\n");
+	else
+		cprintf("WS profiling & prewarming is TURNED ON\n");
+	return 0;
+}
+int command_ws_profile_clear(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: wsprofileclr <program name>\n");
+		return 0;
+	}
+	if (env_ws_profile_clear(arguments[1]) == 0)
+		cprintf("Fault profile of %s is cleared\n", arguments[1]);
+	return 0;
+}
+int command_page_trace(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: pgtrace <0|1> [env ID]\n");
+		return 0;
+	}
+	if (strtol(arguments[1], NULL, 10) == 0)
+	{
+		pgtrace_stop();
+		cprintf("Page trace is STOPPED\n");
+	}
+	else
+	{
+		int32 envId = (number_of_arguments > 2) ? strtol(arguments[2], NULL, 10) : PGTRACE_ALL_ENVS;
+		pgtrace_start(envId);
+		cprintf("Page trace is STARTED (the LRU time stamps are updated at each tick while tracing)\n");
+	}
+	return 0;
+}
+int command_page_trace_dump(int number_of_arguments, char **arguments)
+{
+	int32 envId = (number_of_arguments > 1) ? strtol(arguments[1], NULL, 10) : PGTRACE_ALL_ENVS;
+	pgtrace_dump(envId);
+	return 0;
+}
+int command_ide_dma(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: idedma <0|1>\n");
+		return 0;
+	}
+	if (ide_dma_set(strtol(arguments[1], NULL, 10)))
+		cprintf("Disk transfers use bus-master DMA\n");
+	else
+		cprintf("Disk transfers use PIO\n");
+	return 0;
+}
+int command_async_page_in(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: asyncpf <0|1>\n");
+		return 0;
+	}
+	enableAsyncPageIn(strtol(arguments[1], NULL, 10));
+	if (isAsyncPageInEnabled())
+		cprintf("Page faults are NON-BLOCKING: the page-ins complete at the disk interrupt\n");
+	else
+		cprintf("Page faults are BLOCKING%s\n", ide_dma_enabled ? "" : " (disk DMA is off)");
+	return 0;
+}
+int command_print_disk_queues(int number_of_arguments, char **arguments)
+{
+	dq_print_stats();
+	return 0;
+}
+int command_reset_disk_queues(int number_of_arguments, char **arguments)
+{
+	dq_reset_stats();
+	return 0;
+}
+int command_page_file_stripe(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: pfstripe <1|2> [2nd disk #: 1 = primary slave, 2 = secondary master (default), 3 = secondary slave]\n");
+		return 0;
+	}
+	uint32 numDisks = strtol(arguments[1], NULL, 10);
+	uint32 secondDisk = (number_of_arguments > 2) ? strtol(arguments[2], NULL, 10) : PF_STRIPE_SECOND_DISK;
+	if (pf_set_striping(numDisks, secondDisk) != 0)
+	{
+		cprintf("Can't change the page file layout: the 2nd disk should exist and no env should be loaded\n");
+		return 0;
+	}
+	if (pf_get_num_stripe_disks() > 1)
+		cprintf("The page file is striped over disks 0 and %d\n", secondDisk);
+	else
+		cprintf("The page file is on disk 0 only\n");
+	return 0;
+}
+int command_page_file_header(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: pfheader <size in MB> [start sector (>= %d)]\n", PAGE_FILE_START_SECTOR);
+		cprintf("current page file: %d MB at sector %d\n", pf_num_pages / (1024*1024 / PAGE_SIZE), pf_start_sector);
+		return 0;
+	}
+	uint32 numPages = strtol(arguments[1], NULL, 10) * (1024*1024 / PAGE_SIZE);
+	uint32 startSector = (number_of_arguments > 2) ? strtol(arguments[2], NULL, 10) : PAGE_FILE_START_SECTOR;
+	if (pf_write_header(startSector, numPages) != 0)
+		cprintf("Invalid page file size/location\n");
+	else
+		cprintf("The page file header is written: it's used at the next boot\n");
+	return 0;
+}
+int command_lazy_loading(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: lazyload <0|1>\n");
+		return 0;
+	}
+	int status = strtol(arguments[1], NULL, 10);
+	enableLazyLoading(status);
+	if (status == 0)
+		cprintf("Lazy program loading is TURNED OFF\n");
+	else
+		cprintf("Lazy program loading is TURNED ON\n");
+	return 0;
+}
+int command_shared_text(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments < 2)
+	{
+		cprintf("usage: sharetext <0|1>\n");
+		return 0;
+	}
+	int status = strtol(arguments[1], NULL, 10);
+	enableSharedText(status);
+	if (status == 0)
+		cprintf("Shared program text is TURNED OFF\n");
+	else if (isLazyLoadingEnabled())
+		cprintf("Shared program text is TURNED ON\n");
+	else
+		cprintf("Shared program text is TURNED ON (for the lazily loaded programs only: see lazyload)\n");
+	return 0;
+}
+int command_print_program_store(int number_of_arguments, char **arguments)
+{
+	ps_print();
+	return 0;
+}
+int command_sched_stats(int number_of_arguments, char **arguments)
+{
+	if (number_of_arguments > 1 && strcmp(arguments[1], "reset") == 0)
+	{
+		sched_reset_stats();
+		cprintf("Scheduler statistics are reset\n");
+		return 0;
+	}
+	sched_print_stats();
+	return 0;
+}
+
+int command_set_priority(int number_of_arguments, char **arguments)
+{
+	struct Env* env;
+	if (number_of_arguments < 3)
+	{
+		cprintf("Usage: priority <env ID> <priority: 1 (low) ... 5 (high)>\n");
+		return 0;
+	}
+	int32 envId = strtol(arguments[1], NULL, 10);
+	int priority = strtol(arguments[2], NULL, 10);
+	if (priority < PRIORITY_LOW || priority > PRIORITY_HIGH || envid2env(envId, &env, 0) < 0 || env->env_status == ENV_FREE)
+	{
+		cprintf("Invalid env ID or priority\n");
+		return 0;
+	}
+	set_program_priority(env, priority);
+	cprintf("[%d] %s: priority %d, WS size %d\n", env->env_id, env->prog_name, env->priority, env->page_WS_max_size);
+	return 0;
+}
+
 /*2018*///END======================================================
 
 
@@ -24,5 +24,6 @@ int cons_getc2(void);
 
 void kbd_intr(void); // irq 1
 void serial_intr(void); // irq 4
+void serial_putc(int c);
 
 #endif /* _CONSOLE_H_ */
@@ -0,0 +1,307 @@
+/* See COPYRIGHT for copyright information. */
+
+#include <inc/stdio.h>
+#include <inc/string.h>
+#include <inc/assert.h>
+#include <inc/disk.h>
+
+#include <kern/disk_queue.h>
+
+struct DiskQueue disk_queues[DQ_NUM_QUEUES];
+static const char* disk_queue_names[DQ_NUM_QUEUES] = {"SYNC", "BACKGROUND"};
+
+//sector following the last dispatched command on each disk (the C-LOOK "heads")
+uint32 dq_head_sector[IDE_MAX_DISKS];
+
+//copies of the background writes, and the buffers of the merged commands (one per channel)
+static uint8 dq_buffers[DQ_MAX_DEPTH][DQ_BUFFER_SECTS * SECTSIZE];
+static uint8 dq_buffer_used[DQ_MAX_DEPTH];
+static uint8 dq_merge_buffers[2][DQ_MAX_MERGE_SECTS * SECTSIZE];
+
+//adjacent requests of a queue issued as a single command
+struct DiskRun
+{
+	int first;
+	int count;
+	uint32 nsecs;
+};
+
+static int dq_dispatch(struct DiskQueue* q);
+
+static inline int dq_overlap(struct DiskRequest* req, uint32 disk, uint32 secno, uint32 nsecs)
+{
+	return req->disk == disk && secno < req->secno + req->nsecs && req->secno < secno + nsecs;
+}
+
+//Flushes both queues if the given request conflicts with a queued one (same sectors, one of them is a write)
+void dq_barrier(uint32 disk, uint32 secno, uint32 nsecs, uint8 isWrite)
+{
+	int q, i;
+	for (q = 0; q < DQ_NUM_QUEUES; q++)
+	{
+		for (i = 0; i < disk_queues[q].depth; i++)
+		{
+			struct DiskRequest* req = &disk_queues[q].reqs[i];
+			if ((isWrite || req->isWrite) && dq_overlap(req, disk, secno, nsecs))
+			{
+				dq_flush();
+				return;
+			}
+		}
+	}
+}
+
+//Inserts the request in the queue, keeping it sorted by disk then sector. The queue shouldn't be full
+static void dq_insert(struct DiskQueue* q, uint32 disk, uint32 secno, uint8* buf, uint32 nsecs, uint8 isWrite, int8 bufIndex)
+{
+	int i;
+	assert(q->depth < DQ_MAX_DEPTH);
+	for (i = q->depth; i > 0 && (q->reqs[i-1].disk > disk || (q->reqs[i-1].disk == disk && q->reqs[i-1].secno > secno)); i--)
+	{
+		q->reqs[i] = q->reqs[i-1];
+	}
+	q->reqs[i].disk = disk;
+	q->reqs[i].secno = secno;
+	q->reqs[i].nsecs = nsecs;
+	q->reqs[i].buf = buf;
+	q->reqs[i].isWrite = isWrite;
+	q->reqs[i].bufIndex = bufIndex;
+
+	q->depth++;
+	q->nRequests++;
+	if (q->depth > q->maxDepth)
+		q->maxDepth = q->depth;
+}
+
+//Queues a read into dst. The caller should then call dq_sync() before using dst
+int dq_queue_read(uint32 disk, uint32 secno, void* dst, uint32 nsecs)
+{
+	struct DiskQueue* q = &disk_queues[DQ_SYNC];
+	int ret = 0;
+	assert(disk < IDE_MAX_DISKS && nsecs <= DQ_MAX_MERGE_SECTS);
+
+	dq_barrier(disk, secno, nsecs, 0);
+	if (q->depth == DQ_MAX_DEPTH)
+		ret = dq_dispatch(q);
+	dq_insert(q, disk, secno, dst, nsecs, 0, -1);
+	return ret;
+}
+
+//Queues a write of src. A background write takes a copy of the data, so it returns immediately
+//(it's done later, see dq_flush_background()). Otherwise the caller should call dq_sync() before
+//reusing src.
+int dq_queue_write(uint32 disk, uint32 secno, const void* src, uint32 nsecs, uint8 background)
+{
+	int ret = 0, b;
+	assert(disk < IDE_MAX_DISKS && nsecs <= DQ_MAX_MERGE_SECTS);
+
+	dq_barrier(disk, secno, nsecs, 1);
+
+	if (background && nsecs <= DQ_BUFFER_SECTS)
+	{
+		struct DiskQueue* q = &disk_queues[DQ_BACKGROUND];
+		if (q->depth == DQ_MAX_DEPTH)
+			ret = dq_dispatch(q);
+
+		//the pool has one buffer per queue slot, so a free one always exists here
+		for (b = 0; dq_buffer_used[b]; b++);
+		dq_buffer_used[b] = 1;
+		memcpy(dq_buffers[b], src, nsecs * SECTSIZE);
+		dq_insert(q, disk, secno, dq_buffers[b], nsecs, 1, b);
+		return ret;
+	}
+
+	struct DiskQueue* q = &disk_queues[DQ_SYNC];
+	if (q->depth == DQ_MAX_DEPTH)
+		ret = dq_dispatch(q);
+	dq_insert(q, disk, secno, (uint8*)src, nsecs, 1, -1);
+	return ret;
+}
+
+//Splits the requests [lo, hi) of a single disk into runs, in C-LOOK order from the disk head:
+//each run gathers the adjacent requests of the same direction (never across the wrap)
+static int dq_build_runs(struct DiskQueue* q, int lo, int hi, struct DiskRun* runs)
+{
+	uint32 disk = q->reqs[lo].disk;
+	uint32 maxSects = MIN(DQ_MAX_MERGE_SECTS, ide_max_sectors(disk));
+	int start, first, j, remaining = hi - lo, n = 0;
+
+	for (start = lo; start < hi && q->reqs[start].secno < dq_head_sector[disk]; start++);
+
+	for (first = start; remaining > 0; first = j)
+	{
+		if (first == hi)
+			first = lo;
+
+		uint32 nsecs = q->reqs[first].nsecs;
+		for (j = first + 1; j < hi && j - first < remaining
+				&& q->reqs[j].isWrite == q->reqs[first].isWrite
+				&& q->reqs[j].secno == q->reqs[j-1].secno + q->reqs[j-1].nsecs
+				&& nsecs + q->reqs[j].nsecs <= maxSects; j++)
+		{
+			nsecs += q->reqs[j].nsecs;
+		}
+
+		runs[n].first = first;
+		runs[n].count = j - first;
+		runs[n].nsecs = nsecs;
+		n++;
+		remaining -= j - first;
+	}
+	return n;
+}
+
+//Sets the IDE transfer of the given run: merged runs go through the given merge buffer
+static void dq_prepare(struct DiskQueue* q, struct DiskRun* run, uint8* mergeBuffer, struct IdeTransfer* t)
+{
+	struct DiskRequest* req = &q->reqs[run->first];
+	uint32 offset;
+	int i;
+
+	t->disk = req->disk;
+	t->secno = req->secno;
+	t->nsecs = run->nsecs;
+	t->isWrite = req->isWrite;
+	t->buf = (run->count == 1) ? req->buf : mergeBuffer;
+
+	if (run->count > 1 && req->isWrite)
+	{
+		for (i = run->first, offset = 0; i < run->first + run->count; offset += q->reqs[i].nsecs * SECTSIZE, i++)
+			memcpy(mergeBuffer + offset, q->reqs[i].buf, q->reqs[i].nsecs * SECTSIZE);
+	}
+
+	q->nCommands++;
+	q->nMerged += run->count - 1;
+	dq_head_sector[t->disk] = t->secno + t->nsecs;
+}
+
+//Copies the data of a merged read back to the buffers of its requests
+static void dq_complete(struct DiskQueue* q, struct DiskRun* run, struct IdeTransfer* t, int ret)
+{
+	uint32 offset;
+	int i;
+
+	if (run->count == 1 || t->isWrite || ret != 0)
+		return;
+	for (i = run->first, offset = 0; i < run->first + run->count; offset += q->reqs[i].nsecs * SECTSIZE, i++)
+		memcpy(q->reqs[i].buf, t->buf + offset, q->reqs[i].nsecs * SECTSIZE);
+}
+
+//Issues all the requests of the queue in C-LOOK order (per disk), merging the adjacent ones.
+//The runs of two disks on different channels are issued at the same time.
+//Returns 0, or the error of the first failed command
+static int dq_dispatch(struct DiskQueue* q)
+{
+	static struct DiskRun runs[IDE_MAX_DISKS][DQ_MAX_DEPTH];
+	int nRuns[IDE_MAX_DISKS] = {0};
+	int next[IDE_MAX_DISKS] = {0};
+	struct IdeTransfer ta, tb;
+	int lo, hi, a, b, i, r, ret = 0;
+
+	if (q->depth == 0)
+		return 0;
+	q->nDispatches++;
+	q->depthSum += q->depth;
+
+	//[1] split the requests of each disk into runs
+	for (lo = 0; lo < q->depth; lo = hi)
+	{
+		for (hi = lo; hi < q->depth && q->reqs[hi].disk == q->reqs[lo].disk; hi++);
+		nRuns[q->reqs[lo].disk] = dq_build_runs(q, lo, hi, runs[q->reqs[lo].disk]);
+	}
+
+	//[2] issue them, pairing the disks of different channels
+	for (;;)
+	{
+		for (a = 0; a < IDE_MAX_DISKS && next[a] == nRuns[a]; a++);
+		if (a == IDE_MAX_DISKS)
+			break;
+		for (b = 0; b < IDE_MAX_DISKS && (next[b] == nRuns[b] || IDE_CHANNEL(b) == IDE_CHANNEL(a)); b++);
+
+		struct DiskRun* runA = &runs[a][next[a]++];
+		dq_prepare(q, runA, dq_merge_buffers[0], &ta);
+		if (b == IDE_MAX_DISKS)
+		{
+			r = ide_transfer(&ta);
+			dq_complete(q, runA, &ta, r);
+		}
+		else
+		{
+			struct DiskRun* runB = &runs[b][next[b]++];
+			dq_prepare(q, runB, dq_merge_buffers[1], &tb);
+			r = ide_transfer_pair(&ta, &tb);
+			dq_complete(q, runA, &ta, r);
+			dq_complete(q, runB, &tb, r);
+			q->nConcurrent += 2;
+		}
+		if (r != 0 && ret == 0)
+			ret = r;
+	}
+
+	for (i = 0; i < q->depth; i++)
+	{
+		if (q->reqs[i].bufIndex >= 0)
+			dq_buffer_used[(int)q->reqs[i].bufIndex] = 0;
+	}
+	q->depth = 0;
+	return ret;
+}
+
+//Issues the synchronous requests (the caller is waiting for them)
+int dq_sync()
+{
+	return dq_dispatch(&disk_queues[DQ_SYNC]);
+}
+
+//Issues the background write-backs (called at the clock tick).
+//Returns 0, or the error of the first failed command
+int dq_flush_background()
+{
+	return dq_dispatch(&disk_queues[DQ_BACKGROUND]);
+}
+
+//Issues all the queued requests, the synchronous ones first
+int dq_flush()
+{
+	int ret = dq_sync();
+	int ret2 = dq_flush_background();
+	return ret != 0 ? ret : ret2;
+}
+
+int dq_read(uint32 disk, uint32 secno, void* dst, uint32 nsecs)
+{
+	int ret = dq_queue_read(disk, secno, dst, nsecs);
+	int ret2 = dq_sync();
+	return ret != 0 ? ret : ret2;
+}
+
+int dq_write(uint32 disk, uint32 secno, const void* src, uint32 nsecs)
+{
+	int ret = dq_queue_write(disk, secno, src, nsecs, 0);
+	int ret2 = dq_sync();
+	return ret != 0 ? ret : ret2;
+}
+
+void dq_print_stats()
+{
+	int q;
+	for (q = 0; q < DQ_NUM_QUEUES; q++)
+	{
+		struct DiskQueue* queue = &disk_queues[q];
+		cprintf("%s queue: depth = %d (max %d, avg %d at dispatch), requests = %d, commands = %d (%d concurrent), merged = %d\n",
+				disk_queue_names[q], queue->depth, queue->maxDepth,
+				queue->nDispatches ? queue->depthSum / queue->nDispatches : 0,
+				queue->nRequests, queue->nCommands, queue->nConcurrent, queue->nMerged);
+	}
+}
+
+void dq_reset_stats()
+{
+	int q;
+	for (q = 0; q < DQ_NUM_QUEUES; q++)
+	{
+		disk_queues[q].nRequests = disk_queues[q].nCommands = disk_queues[q].nMerged = 0;
+		disk_queues[q].nConcurrent = disk_queues[q].nDispatches = disk_queues[q].depthSum = 0;
+		disk_queues[q].maxDepth = disk_queues[q].depth;
+	}
+}
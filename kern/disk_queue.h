@@ -0,0 +1,71 @@
+/* See COPYRIGHT for copyright information. */
+
+#ifndef FOS_KERN_DISK_QUEUE_H
+#define FOS_KERN_DISK_QUEUE_H
+#ifndef FOS_KERNEL
+# error "This is a FOS kernel header; user programs should not #include it"
+#endif
+
+#include <inc/types.h>
+#include <inc/disk.h>
+
+//2026: disk request queue
+//========================
+//The page file requests are queued between the pf_* functions and ide_read()/ide_write().
+//Each queue is kept sorted by sector and dispatched in C-LOOK order (ascending from the
+//last dispatched sector, then wrapping to the lowest one), merging adjacent requests of the
+//same direction into single commands of at most DQ_MAX_MERGE_SECTS sectors: the size of the DMA
+//bounce buffer, so ide_transfer() moves a merged command in one copy.
+//The SYNC queue holds the requests someone is waiting for (faults): it's dispatched by dq_sync().
+//The BACKGROUND queue holds the write-backs: their data is copied, so the caller doesn't wait,
+//and they're dispatched at the clock tick (or when the queue is full), after the SYNC ones.
+//A request that overlaps a queued one (and one of them is a write) flushes both queues first,
+//so the queued requests never depend on each other's order.
+//The requests carry their disk (the page file can be striped, see file_manager.h): each disk has its
+//own C-LOOK head, and the commands of disks on different channels are issued at the same time.
+
+#define DQ_SYNC				0
+#define DQ_BACKGROUND		1
+#define DQ_NUM_QUEUES		2
+
+#define DQ_MAX_DEPTH		32		//max # requests in each queue
+#define DQ_MAX_MERGE_SECTS	IDE_DMA_BOUNCE_SECTS	//max # sectors of a merged command (also limited by ide_max_sectors())
+#define DQ_BUFFER_SECTS		8		//max # sectors of a background write (one page); larger ones are synchronous
+
+struct DiskRequest
+{
+	uint32 disk;
+	uint32 secno;
+	uint32 nsecs;
+	uint8* buf;			//caller's buffer (SYNC) or a copy of the data (BACKGROUND)
+	uint8 isWrite;
+	int8 bufIndex;		//index of the copy in the buffer pool (-1 if the caller's buffer)
+};
+
+struct DiskQueue
+{
+	struct DiskRequest reqs[DQ_MAX_DEPTH];	//sorted by disk, then by sector
+	uint32 depth;
+
+	//statistics (see dq_print_stats())
+	uint32 nRequests;		//# queued requests
+	uint32 nCommands;		//# IDE commands issued
+	uint32 nConcurrent;		//# of them issued together with a command on the other channel
+	uint32 nMerged;			//# requests merged into the command of a previous one
+	uint32 nDispatches;		//# times the queue was dispatched
+	uint32 depthSum;		//sum of the depths at dispatch (average depth = depthSum / nDispatches)
+	uint32 maxDepth;
+};
+
+int dq_queue_read(uint32 disk, uint32 secno, void* dst, uint32 nsecs);
+int dq_queue_write(uint32 disk, uint32 secno, const void* src, uint32 nsecs, uint8 background);
+int dq_sync();
+int dq_flush();
+int dq_flush_background();
+void dq_barrier(uint32 disk, uint32 secno, uint32 nsecs, uint8 isWrite);
+int dq_read(uint32 disk, uint32 secno, void* dst, uint32 nsecs);
+int dq_write(uint32 disk, uint32 secno, const void* src, uint32 nsecs);
+void dq_print_stats();
+void dq_reset_stats();
+
+#endif /* !FOS_KERN_DISK_QUEUE_H */
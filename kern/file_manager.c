@@ -18,10 +18,13 @@ FUNCTIONS:	to_physical_address, get_frame_info, tlb_invalidate
 #include <inc/assert.h>
 #include <inc/disk.h>
 #include <inc/environment_definitions.h>
+#include <inc/x86.h>
 
 #include <kern/file_manager.h>
 #include <kern/memory_manager.h>
 #include <kern/kheap.h>
+#include <kern/sched.h>
+#include <kern/disk_queue.h>
 
 int pf_add_env_page(struct Env* ptr_env, uint32 virtual_address, void* ptrDataSrc);
 int __pf_write_env_table( struct Env* ptr_env, uint32 virtual_address, uint32* tableKVirtualAddress);
@@ -32,10 +35,11 @@ void __pf_remove_env_table(struct Env* ptr_env, uint32 virtual_address);
 
 int read_disk_page(uint32 dfn, void* va)
 {
-	uint32 df_start_sector = PAGE_FILE_START_SECTOR+dfn*SECTOR_PER_PAGE;
+	uint32 disk, df_start_sector;
+	pf_disk_frame_location(dfn, &disk, &df_start_sector);
 
 	//LOG_STATMENT( cprintf("reading from disk to mem addr %x at sector %d\n",va,df_start_sector);  );
-	int success = ide_read(df_start_sector, (void*)va, SECTOR_PER_PAGE);
+	int success = dq_read(disk, df_start_sector, (void*)va, SECTOR_PER_PAGE);
 	//LOG_STATMENT( if(success==0) {cprintf("read from disk successuflly.\n");} else {cprintf("read from disk failed !!\n");} );
 
 	return success;
@@ -45,10 +49,12 @@ int read_disk_page(uint32 dfn, void* va)
 int write_disk_page(uint32 dfn, void* va)
 {
 	//write disk at wanted frame
-	uint32 df_start_sector = PAGE_FILE_START_SECTOR+dfn*SECTOR_PER_PAGE;
+	uint32 disk, df_start_sector;
+	pf_disk_frame_location(dfn, &disk, &df_start_sector);
 
 	//LOG_STATMENT( cprintf(">>> writing to disk from mem addr %x at sector %d\n",va,df_start_sector);  );
-	int success = ide_write(df_start_sector, (void*)va, SECTOR_PER_PAGE);
+	//2026: queued as a background write-back (the data is copied, so va can be reused at once)
+	int success = dq_queue_write(disk, df_start_sector, (void*)va, SECTOR_PER_PAGE, 1);
 	//LOG_STATMENT( if(success==0) {cprintf(">>> written to disk successfully.\n");} else {cprintf(">>> written to disk failed !!\n");} );
 
 	if(success != 0)
@@ -60,8 +66,21 @@ int write_disk_page(uint32 dfn, void* va)
 
 uint32* ptr_disk_page_directory;
 
-struct Frame_Info* disk_frames_info;
-struct Linked_List disk_free_frame_list;
+//2026: the page file slots are tracked by a bitmap (bit set = used), allocated at boot for the
+//discovered page file size. The free frames are counted per stripe disk.
+uint32* disk_frames_bitmap;
+uint32 pf_start_sector = PAGE_FILE_START_SECTOR;
+uint32 pf_num_pages = PAGE_FILE_SIZE / PAGE_SIZE;
+static uint32 pf_free_frames[PF_MAX_STRIPE_DISKS];
+static uint32 pf_alloc_word[PF_MAX_STRIPE_DISKS];		//bitmap word where the next search starts (next fit)
+//2026: the bitmap words [pf_bitmap_init_words, end) aren't initialized yet: they're initialized by
+//chunks of PF_INIT_CHUNK_WORDS when the allocator reaches them (or when the kernel is idle)
+static uint32 pf_bitmap_init_words;
+
+//2026: page file striping (see file_manager.h)
+uint32 pf_num_stripe_disks = PF_STRIPE_DISKS;
+uint32 pf_stripe_disks[PF_MAX_STRIPE_DISKS] = {0, PF_STRIPE_SECOND_DISK};
+static uint32 pf_next_stripe;		//stripe of the next allocated disk frame
 
 void initialize_disk_page_file();
 
@@ -69,51 +88,150 @@ int read_disk_page(uint32 dfn, void* va);
 int write_disk_page(uint32 dfn, void* va);
 
 int get_disk_page_directory(struct Env* ptr_env, uint32** ptr_disk_page_directory);
+int pf_calculate_free_frames();
 
 
 
 
 // --------------------------------------------------------------
-// Tracking of physical frames.
-// The 'frames_info' array has one 'struct Frame_Info' entry per physical frame.
-// frames_info are reference counted, and free frames are kept on a linked list.
+// Tracking of disk frames.
+// 2026: 'disk_frames_bitmap' has one bit per disk frame (set if used).
 // --------------------------------------------------------------
 
-// Initialize paging structure and disk_free_frame_list.
-// After this point, ONLY use the functions below
-// to allocate and deallocate physical memory via the disk_free_frame_list,
-// and NEVER use boot_allocate_space() or the related boot-time functions above.
-//
-void initialize_disk_page_file()
+//2026: Finds the page file location & size (see file_manager.h). Called at boot, before
+//the bitmap is allocated. Returns the # disk frames
+uint32 pf_discover_size()
 {
-	int i;
-	LIST_INIT(&disk_free_frame_list);
+	uint8 sector[SECTOR_SIZE];
+	struct PageFileHeader* header = (struct PageFileHeader*)sector;
+	uint32 nsectors;
 
-	//LOG_STATMENT(cprintf("PAGES_PER_FILE = %d, PAGE_FILE_START_SECTOR = %d\n",PAGES_PER_FILE,PAGE_FILE_START_SECTOR););
-	for (i = 1; i < PAGES_PER_FILE; i++)
+	pf_start_sector = PAGE_FILE_START_SECTOR;
+	pf_num_pages = PAGE_FILE_SIZE / PAGE_SIZE;
+	if (ide_identify(0, &nsectors) == 0 && nsectors > PAGE_FILE_START_SECTOR)
 	{
-		initialize_frame_info(&(disk_frames_info[i]));
+		//(only a header makes it larger than the default size)
+		pf_num_pages = MIN(pf_num_pages, (nsectors - PAGE_FILE_START_SECTOR) / SECTOR_PER_PAGE);
+		if (dq_read(0, PF_HEADER_SECTOR, sector, 1) == 0 && header->magic == PF_HEADER_MAGIC
+				&& header->start_sector >= PAGE_FILE_START_SECTOR && header->num_pages > 1
+				&& header->start_sector + header->num_pages * SECTOR_PER_PAGE <= nsectors)
+		{
+			pf_start_sector = header->start_sector;
+			pf_num_pages = header->num_pages;
+		}
+	}
+	if (pf_num_pages > PF_MAX_PAGES)
+		pf_num_pages = PF_MAX_PAGES;
+
+	cprintf("Page file: %d MB at sector %d (%d KB of slot bitmap)\n", pf_num_pages / (1024*1024 / PAGE_SIZE),
+			pf_start_sector, ROUNDUP(pf_num_pages, 32) / 8 / 1024);
+	return pf_num_pages;
+}
+
+//2026: Writes the page file header (num_pages = 0 removes it). It takes effect at the next boot
+int pf_write_header(uint32 start_sector, uint32 num_pages)
+{
+	uint8 sector[SECTOR_SIZE];
+	struct PageFileHeader* header = (struct PageFileHeader*)sector;
+
+	if (num_pages != 0 && (start_sector < PAGE_FILE_START_SECTOR || num_pages < 2 || num_pages > PF_MAX_PAGES))
+		return E_INVAL;
 
-		//disk_frames_info[i].references = 0;
-		LIST_INSERT_HEAD(&disk_free_frame_list, &disk_frames_info[i]);
+	memset(sector, 0, SECTOR_SIZE);
+	header->magic = (num_pages != 0) ? PF_HEADER_MAGIC : 0;
+	header->start_sector = start_sector;
+	header->num_pages = num_pages;
+	return dq_write(0, PF_HEADER_SECTOR, sector, 1);
+}
+
+//2026: Initializes the next chunk of the disk frames bitmap (all its frames are free).
+//Returns 0 if the whole bitmap is already initialized
+uint32 pf_initialize_bitmap_chunk()
+{
+	uint32 nwords = ROUNDUP(pf_num_pages, 32) / 32;
+	uint32 end = MIN(pf_bitmap_init_words + PF_INIT_CHUNK_WORDS, nwords);
+	uint32 i;
+
+	if (pf_bitmap_init_words == nwords)
+		return 0;
+	memset(&disk_frames_bitmap[pf_bitmap_init_words], 0, (end - pf_bitmap_init_words) * sizeof(uint32));
+	if (pf_bitmap_init_words == 0)
+		disk_frames_bitmap[0] |= 1;
+	//the bits beyond the last frame are never free
+	if (end == nwords)
+	{
+		for (i = pf_num_pages; i < nwords * 32; i++)
+			disk_frames_bitmap[i / 32] |= 1 << (i % 32);
 	}
+	pf_bitmap_init_words = end;
+	return 1;
 }
 
+// Initialize the disk frames bitmap: all the frames are free, except frame 0
+// (dfn 0 means "not in the page file")
+// 2026: only its first chunk is initialized here (see pf_initialize_bitmap_chunk())
 //
-// Initialize a Frame_Info structure.
-// The result has null links and 0 references.
-// Note that the corresponding physical frame is NOT initialized!
-//
-static inline uint32 to_disk_frame_number(struct Frame_Info *ptr_frame_info)
+void initialize_disk_page_file()
+{
+	uint32 i;
+
+	pf_bitmap_init_words = 0;
+	pf_initialize_bitmap_chunk();
+
+	pf_next_stripe = 0;
+	for (i = 0; i < pf_num_stripe_disks; i++)
+	{
+		pf_free_frames[i] = (pf_num_pages - i + pf_num_stripe_disks - 1) / pf_num_stripe_disks;
+		pf_alloc_word[i] = 0;
+	}
+	pf_free_frames[0]--;
+}
+
+//2026: Returns the disk and the start sector of the given disk frame
+void pf_disk_frame_location(uint32 dfn, uint32* disk, uint32* secno)
+{
+	*disk = pf_stripe_disks[dfn % pf_num_stripe_disks];
+	*secno = pf_start_sector + (dfn / pf_num_stripe_disks) * SECTOR_PER_PAGE;
+}
+
+//2026: Stripes the page file over numDisks disks (1 or 2; secondDisk is the IDE disk # of the 2nd one).
+//The layout can only change while the page file is empty (no env is loaded)
+int pf_set_striping(uint32 numDisks, uint32 secondDisk)
+{
+	uint32 nsectors;
+	if (numDisks < 1 || numDisks > PF_MAX_STRIPE_DISKS || secondDisk == 0 || secondDisk >= IDE_MAX_DISKS)
+		return E_INVAL;
+	if (pf_calculate_free_frames() != pf_num_pages - 1)
+		return E_INVAL;
+	//the 2nd disk should hold its half of the page file at the same location
+	if (numDisks > 1 && (ide_identify(secondDisk, &nsectors) != 0
+			|| nsectors < pf_start_sector + (pf_num_pages / numDisks + 1) * SECTOR_PER_PAGE))
+		return E_INVAL;
+
+	dq_flush();
+	pf_num_stripe_disks = numDisks;
+	pf_stripe_disks[1] = secondDisk;
+	initialize_disk_page_file();
+	return 0;
+}
+
+uint32 pf_get_num_stripe_disks()
 {
-	return ptr_frame_info - disk_frames_info;
+	return pf_num_stripe_disks;
+}
+
+//bits of a bitmap word that belong to the given stripe disk (the frames alternate between them)
+static inline uint32 pf_stripe_mask(uint32 stripe)
+{
+	if (pf_num_stripe_disks == 1)
+		return 0xFFFFFFFF;
+	return (stripe == 0) ? 0x55555555 : 0xAAAAAAAA;
 }
 
 //
 // Allocates a disk frame.
 //
-// *ptr_frame_info -- is set to point to the Frame_Info struct of the
-// newly allocated frame
+// *dfn -- is set to the number of the newly allocated frame
 //
 // RETURNS
 //   0 -- on success
@@ -122,24 +240,48 @@ static inline uint32 to_disk_frame_number(struct Frame_Info *ptr_frame_info)
 int allocate_disk_frame(uint32 *dfn)
 {
 	// Fill this function in
-	struct Frame_Info *ptr_frame_info = LIST_FIRST(&disk_free_frame_list);
-	if(ptr_frame_info == NULL)
+	//2026: take the frames from the stripe disks in turn, so that consecutive allocations
+	//(e.g. the pages of a loaded program) are spread over all of them
+	uint32 nwords = ROUNDUP(pf_num_pages, 32) / 32;
+	uint32 i, stripe = 0, w, freeBits, bit;
+	for (i = 0; i < pf_num_stripe_disks; i++)
+	{
+		stripe = (pf_next_stripe + i) % pf_num_stripe_disks;
+		if (pf_free_frames[stripe] > 0)
+			break;
+	}
+	if (i == pf_num_stripe_disks)
 		return E_NO_PAGE_FILE_SPACE;
 
-	LIST_REMOVE(&disk_free_frame_list, ptr_frame_info);
-	initialize_frame_info(ptr_frame_info);
-	*dfn = to_disk_frame_number(ptr_frame_info);
+	//next fit: a free frame of this stripe exists, so the search ends
+	//(the words not initialized yet are initialized when the search reaches them)
+	for (w = pf_alloc_word[stripe]; ; w = (w + 1) % nwords)
+	{
+		while (w >= pf_bitmap_init_words)
+			pf_initialize_bitmap_chunk();
+		if ((freeBits = ~disk_frames_bitmap[w] & pf_stripe_mask(stripe)) != 0)
+			break;
+	}
+	for (bit = 0; (freeBits & (1 << bit)) == 0; bit++);
+
+	disk_frames_bitmap[w] |= 1 << bit;
+	pf_free_frames[stripe]--;
+	pf_alloc_word[stripe] = w;
+	pf_next_stripe = (stripe + 1) % pf_num_stripe_disks;
+	*dfn = w * 32 + bit;
 	return 0;
 }
 
 //
-// Return a frame to the disk_free_frame_list.
+// Return a frame to the free disk frames.
 //
 inline void free_disk_frame(uint32 dfn)
 {
 	// Fill this function in
-	if(dfn == 0) return;
-	LIST_INSERT_HEAD(&disk_free_frame_list, &disk_frames_info[dfn]);
+	if(dfn == 0 || dfn >= pf_num_pages) return;
+	if ((disk_frames_bitmap[dfn / 32] & (1 << (dfn % 32))) == 0) return;
+	disk_frames_bitmap[dfn / 32] &= ~(1 << (dfn % 32));
+	pf_free_frames[dfn % pf_num_stripe_disks]++;
 }
 
 int get_disk_page_table(uint32 *ptr_disk_page_directory, const void *virtual_address, int create, uint32 **ptr_disk_page_table)
@@ -267,11 +409,15 @@ int pf_update_env_page(struct Env* ptr_env, void *virtual_address, struct Frame_
 	//Get/Create the directory table
 	get_disk_page_directory(ptr_env, &(ptr_env->disk_env_pgdir)) ;
 
-	get_disk_page_table(ptr_env->disk_env_pgdir, virtual_address, 0, &ptr_disk_page_table);
-	if(ptr_disk_page_table == 0) return E_PAGE_NOT_EXIST_IN_PF;
+	get_disk_page_table(ptr_env->disk_env_pgdir, virtual_address, 1, &ptr_disk_page_table);
 
+	//2026: first write-back of a lazily loaded page (see env_page_lazy_fill()): it gets its slot now
 	uint32 dfn=ptr_disk_page_table[PTX(virtual_address)];
-	if( dfn == 0) return E_PAGE_NOT_EXIST_IN_PF;
+	if( dfn == 0)
+	{
+		if( allocate_disk_frame(&dfn) == E_NO_PAGE_FILE_SPACE) return E_NO_PAGE_FILE_SPACE;
+		ptr_disk_page_table[PTX(virtual_address)] = dfn;
+	}
 
 	int ret;
 	if(USE_KHEAP)
@@ -340,6 +486,179 @@ int pf_read_env_page(struct Env* ptr_env, void *virtual_address)
 	return disk_read_error;
 }
 
+//2026
+//Returns the disk frame # of the given page, or 0 if it doesn't exist in the page file
+uint32 pf_get_env_page_dfn(struct Env* ptr_env, uint32 virtual_address)
+{
+	uint32 *ptr_disk_page_table;
+
+	if( ptr_env->disk_env_pgdir == 0) return 0;
+
+	get_disk_page_table(ptr_env->disk_env_pgdir, (void*)virtual_address, 0, &ptr_disk_page_table);
+	if(ptr_disk_page_table == 0) return 0;
+
+	return ptr_disk_page_table[PTX(virtual_address)];
+}
+
+//2026
+//Reads the given pages of ptr_env from the page file. The pages should be already mapped
+//in the currently loaded directory (i.e. ptr_env's one). The reads are queued together, so
+//the disk queue sorts them and merges the consecutive disk frames into multi-sector commands.
+int pf_read_env_pages_batch(struct Env* ptr_env, uint32* virtual_addresses, uint32 count)
+{
+	uint32 dfns[PF_BATCH_MAX_COUNT];
+	int i, ret = 0;
+
+	if (count > PF_BATCH_MAX_COUNT)
+		count = PF_BATCH_MAX_COUNT;
+
+	//[1] get the disk frames
+	for (i = 0; i < count; i++)
+	{
+		dfns[i] = pf_get_env_page_dfn(ptr_env, ROUNDDOWN(virtual_addresses[i], PAGE_SIZE));
+		if (dfns[i] == 0)
+			return E_PAGE_NOT_EXIST_IN_PF;
+	}
+
+	//[2] queue all the reads, then wait for them
+	for (i = 0; i < count; i++)
+	{
+		uint32 disk, secno;
+		pf_disk_frame_location(dfns[i], &disk, &secno);
+		int r = dq_queue_read(disk, secno, (void*)ROUNDDOWN(virtual_addresses[i], PAGE_SIZE), SECTOR_PER_PAGE);
+		if (r != 0 && ret == 0)
+			ret = r;
+	}
+	int r = dq_sync();
+	if (ret == 0)
+		ret = r;
+
+	for (i = 0; i < count; i++)
+	{
+		//as in pf_read_env_page(): the kernel copy shouldn't mark the page as modified
+		pt_set_page_permissions(ptr_env, ROUNDDOWN(virtual_addresses[i], PAGE_SIZE), 0, PERM_MODIFIED | PERM_USED);
+	}
+	return ret;
+}
+
+//2026
+int pf_read_program_profile(uint32 program_index, struct ProgramProfile* profile)
+{
+	if (program_index >= PF_PROFILE_MAX_PROGRAMS)
+		return E_INVAL;
+	return dq_read(0, PF_PROFILE_START_SECTOR + program_index, profile, 1);
+}
+
+int pf_write_program_profile(uint32 program_index, struct ProgramProfile* profile)
+{
+	if (program_index >= PF_PROFILE_MAX_PROGRAMS)
+		return E_INVAL;
+	return dq_write(0, PF_PROFILE_START_SECTOR + program_index, profile, 1);
+}
+
+//=================================================
+// 2026: NON-BLOCKING PAGE FAULTS
+//=================================================
+//The faulted env is BLOCKED while its page is read by DMA, and other envs run meanwhile.
+//The read completes at the IDE interrupt (IRQ14): the page is copied into the env and it
+//becomes READY again. One read is in flight at a time, the others wait in env_blocked_queue.
+//It's off by default (turned on by the "asyncpf" command) and needs the disk DMA.
+
+uint32 _EnableAsyncPageIn = 0;
+void enableAsyncPageIn(uint32 enableIt){_EnableAsyncPageIn = enableIt;}
+uint32 isAsyncPageInEnabled(){ return _EnableAsyncPageIn && ide_dma_enabled; }
+
+//env whose page is currently read (NULL if none or if it exited meanwhile)
+struct Env* pf_async_env = NULL;
+
+//Loads the page of the given (BLOCKED) env synchronously and makes it READY
+static void pf_async_read_sync(struct Env* e)
+{
+	uint32 oldDir = rcr3();
+	lcr3(e->env_cr3);
+	pf_read_env_page(e, (void*)e->pendingPageInVA);
+	pt_set_page_permissions(e, e->pendingPageInVA, 0, PERM_MODIFIED);
+	lcr3(oldDir);
+
+	e->pendingPageInVA = 0;
+	sched_unblock_env(e);
+}
+
+//Starts the read of the next blocked env (the oldest one) if the disk is free
+static void pf_async_start_next()
+{
+	while (pf_async_env == NULL && ide_async_state == IDE_ASYNC_IDLE && !LIST_EMPTY(&env_blocked_queue))
+	{
+		struct Env* e = LIST_LAST(&env_blocked_queue);
+		uint32 disk, secno;
+		pf_disk_frame_location(pf_get_env_page_dfn(e, e->pendingPageInVA), &disk, &secno);
+		//the page may still be waiting for its write-back in the disk queue
+		dq_barrier(disk, secno, SECTOR_PER_PAGE, 0);
+		//(the asynchronous read is on the first disk only: the stripes of the other one are read by PIO)
+		if (disk == 0 && ide_read_async(secno, SECTOR_PER_PAGE) == 0)
+		{
+			pf_async_env = e;
+			return;
+		}
+		//DMA failed (or other disk): read it by PIO now
+		pf_async_read_sync(e);
+	}
+}
+
+//Blocks the env until the given page (already mapped in its directory) is read from the page file
+int pf_read_env_page_async(struct Env* e, uint32 virtual_address)
+{
+	virtual_address = ROUNDDOWN(virtual_address, PAGE_SIZE);
+	if (pf_get_env_page_dfn(e, virtual_address) == 0)
+		return E_PAGE_NOT_EXIST_IN_PF;
+
+	e->pendingPageInVA = virtual_address;
+	sched_block_env(e);
+	pf_async_start_next();
+	return 0;
+}
+
+//Completes the in-flight read (if it finished, or waits for it if wait = 1) and starts the next one.
+//Called by the IDE interrupt, the clock interrupt and the scheduler when only blocked envs remain.
+void pf_async_complete(uint8 wait)
+{
+	uint32 state = ide_async_poll(wait);
+	if (state == IDE_ASYNC_BUSY)
+		return;
+
+	struct Env* e = pf_async_env;
+	pf_async_env = NULL;
+	if (state == IDE_ASYNC_DONE || state == IDE_ASYNC_ERROR)
+	{
+		if (e == NULL)
+		{
+			//its env was killed meanwhile: drop the data
+			ide_async_collect(NULL);
+		}
+		else
+		{
+			uint32 oldDir = rcr3();
+			lcr3(e->env_cr3);
+			if (ide_async_collect((void*)e->pendingPageInVA) != 0)
+				pf_read_env_page(e, (void*)e->pendingPageInVA);
+			pt_set_page_permissions(e, e->pendingPageInVA, 0, PERM_MODIFIED);
+			lcr3(oldDir);
+
+			e->pendingPageInVA = 0;
+			sched_unblock_env(e);
+		}
+	}
+	pf_async_start_next();
+}
+
+//Forgets the pending page-in of the given env (called when it's freed)
+void pf_async_cancel(struct Env* e)
+{
+	if (pf_async_env == e)
+		pf_async_env = NULL;
+	e->pendingPageInVA = 0;
+}
+
 void pf_remove_env_page(struct Env* ptr_env, uint32 virtual_address)
 {
 	//LOG_STRING("pf_remove_env_page: 0");
@@ -513,15 +832,15 @@ int pf_calculate_allocated_pages(struct Env* ptr_env)
 }
 
 //2016:
-//calculate the disk free frames from the disk free frame list
+//calculate the disk free frames (2026: from the free counters of the stripe disks)
 int pf_calculate_free_frames()
 {
-	struct Frame_Info *ptr;
 	uint32 totalFreeDiskFrames = 0 ;
+	int i;
 
-	LIST_FOREACH(ptr, &disk_free_frame_list)
+	for (i = 0; i < pf_num_stripe_disks; i++)
 	{
-		totalFreeDiskFrames++ ;
+		totalFreeDiskFrames += pf_free_frames[i];
 	}
 	return totalFreeDiskFrames;
 }
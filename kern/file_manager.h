@@ -5,13 +5,67 @@
 #endif
 
 #include <inc/x86.h>
+#include <inc/environment_definitions.h>
 
 #define SECTOR_SIZE 512
-#define PAGE_FILE_START_SECTOR ( (20<<20) /SECTOR_SIZE)  //start sector number of Page file in H.D.
+#define PAGE_FILE_START_SECTOR ( (20<<20) /SECTOR_SIZE)  //default start sector number of Page file in H.D.
 #define SECTOR_PER_PAGE (PAGE_SIZE/SECTOR_SIZE)
 
-#define PAGE_FILE_SIZE (520 << 20)   	//page file size in MB
-#define PAGES_PER_FILE (PAGE_FILE_SIZE/PAGE_SIZE)
+//2026: the page file location & size are discovered at boot by pf_discover_size(): from the page
+//file header (if written by the "pfheader" command), otherwise it's PAGE_FILE_SIZE at
+//PAGE_FILE_START_SECTOR (less if the disk is smaller, from its IDENTIFY data).
+#define PAGE_FILE_SIZE (520 << 20)   	//default page file size in MB
+#define PF_MAX_PAGES (1 << 27)			//512 GB: the sector #s stay 32-bit
+extern uint32 pf_start_sector;			//start sector of the page file (on each stripe disk)
+extern uint32 pf_num_pages;				//# disk frames of the page file (frame 0 isn't used)
+
+//2026: Per-program fault profiles (for prewarming the WS at env_create)
+//They're kept one per sector in an area reserved just before the default page file start
+#define PF_PROFILE_PAGES 32
+#define PF_PROFILE_START_SECTOR (PAGE_FILE_START_SECTOR - PF_PROFILE_PAGES * SECTOR_PER_PAGE)
+#define PF_PROFILE_MAX_PROGRAMS (PF_PROFILE_PAGES * SECTOR_PER_PAGE)
+#define PF_PROFILE_MAGIC 0x464F5250
+#define PF_PROFILE_MAX_PAGES 110
+
+struct ProgramProfile
+{
+	uint32 magic;
+	char prog_name[PROGNAMELEN];
+	uint32 count;						//# recorded pages
+	uint32 va[PF_PROFILE_MAX_PAGES];	//faulted pages in the order of their first fault
+};
+
+//2026: page file header, in the sector just before the profiles
+#define PF_HEADER_SECTOR (PF_PROFILE_START_SECTOR - 1)
+#define PF_HEADER_MAGIC 0x46485046
+
+struct PageFileHeader
+{
+	uint32 magic;
+	uint32 start_sector;		//>= PAGE_FILE_START_SECTOR
+	uint32 num_pages;
+};
+
+//2026: striping of the page file over 2 disks
+//The disk frames alternate between the stripe disks (a page per stripe): frame dfn is on disk
+//pf_stripe_disks[dfn % #disks], at page (dfn / #disks) of the page file area of that disk.
+//The # disks is set at build time (e.g. make DEFS=-DPF_STRIPE_DISKS=2) or by the "pfstripe" command.
+//The second disk is best on the other IDE channel, so that both transfer at the same time.
+#ifndef PF_STRIPE_DISKS
+#define PF_STRIPE_DISKS 1
+#endif
+#ifndef PF_STRIPE_SECOND_DISK
+#define PF_STRIPE_SECOND_DISK 2		//IDE disk # (2 = secondary channel master)
+#endif
+#define PF_MAX_STRIPE_DISKS 2
+
+//max # pages read by a single call of pf_read_env_pages_batch()
+#define PF_BATCH_MAX_COUNT 128
+
+//2026: the disk frames bitmap is initialized by chunks of PF_INIT_CHUNK_WORDS words (32 frames each):
+//the first one at boot, the others when the allocator reaches them or when the kernel is idle
+#define PF_INIT_CHUNK_WORDS 1024
+uint32 pf_initialize_bitmap_chunk();
 
 ///=============================================================================================
 
@@ -21,6 +75,22 @@ int pf_update_env_page(struct Env* ptr_env, void *virtual_address, struct Frame_
 int pf_read_env_page(struct Env* ptr_env, void *virtual_address);
 void pf_remove_env_page(struct Env* ptr_env, uint32 virtual_address);
 int pf_add_env_page( struct Env* ptr_env, uint32 virtual_address, void* dataSrc);
+uint32 pf_get_env_page_dfn(struct Env* ptr_env, uint32 virtual_address);
+void pf_disk_frame_location(uint32 dfn, uint32* disk, uint32* secno);
+uint32 pf_discover_size();
+int pf_write_header(uint32 start_sector, uint32 num_pages);
+int pf_set_striping(uint32 numDisks, uint32 secondDisk);
+uint32 pf_get_num_stripe_disks();
+int pf_read_env_pages_batch(struct Env* ptr_env, uint32* virtual_addresses, uint32 count);
+int pf_read_program_profile(uint32 program_index, struct ProgramProfile* profile);
+int pf_write_program_profile(uint32 program_index, struct ProgramProfile* profile);
+
+//2026: non-blocking page faults
+void enableAsyncPageIn(uint32 enableIt);
+uint32 isAsyncPageInEnabled();
+int pf_read_env_page_async(struct Env* e, uint32 virtual_address);
+void pf_async_complete(uint8 wait);
+void pf_async_cancel(struct Env* e);
 ///=============================================================================================
 
 int pf_calculate_allocated_pages(struct Env* ptr_env);
@@ -4,6 +4,7 @@
 #include <inc/string.h>
 #include <inc/assert.h>
 #include <inc/memlayout.h>
+#include <inc/disk.h>
 
 #include <kern/command_prompt.h>
 #include <kern/console.h>
@@ -15,6 +16,8 @@
 #include <kern/picirq.h>
 #include <kern/sched.h>
 #include <kern/utilities.h>
+#include <kern/file_manager.h>
+#include <kern/program_store.h>
 #include <inc/timerreg.h>
 
 //Functions Declaration
@@ -44,10 +47,21 @@ void FOS_initialize()
 	//print welcome message
 	print_welcome_message();
 
+	//2026: use bus-master DMA for the disk (page file) if the IDE controller supports it
+	ide_dma_init();
+
 	// Lab 2 memory management initialization functions
 	detect_memory();
 	initialize_kernel_VM();
 	initialize_paging();
+	//2026: the page file is striped at build time => its 2nd disk should be there
+	if (PF_STRIPE_DISKS > 1 && pf_set_striping(PF_STRIPE_DISKS, PF_STRIPE_SECOND_DISK) != 0)
+	{
+		cprintf("Page file: disk %d not found, the page file is on disk 0 only\n", PF_STRIPE_SECOND_DISK);
+		pf_set_striping(1, PF_STRIPE_SECOND_DISK);
+	}
+	//2026: read the index of the user programs stored on the disk
+	ps_init();
 //	page_check();
 
 
@@ -66,6 +80,9 @@ void FOS_initialize()
 
 	// Lab 4 multitasking initialization functions
 	pic_init();
+	//2026: the IDE interrupt completes the non-blocking page-ins (DMA only)
+	if (ide_dma_enabled)
+		irq_enable_device_8259A(IDE_IRQ);
 
 	kclock_start(CLOCK_INTERVAL_IN_MS);
 	sched_init() ;
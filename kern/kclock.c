@@ -10,6 +10,7 @@
 
 #include <kern/kclock.h>
 #include <kern/picirq.h>
+#include <kern/lapic.h>
 
 #include <inc/assert.h>
 
@@ -33,8 +34,19 @@ kclock_start(uint8 quantum)
 {
 	//uint16 cnt0 = kclock_read_cnt0() ;
 
-	/* initialize 8253 clock to interrupt N times/sec, N = 1 sec / CLOCK_INTERVAL */
-	outb(TIMER_MODE, TIMER_SEL0 | TIMER_RATEGEN | TIMER_16BIT);
+	//2026: the TSC is calibrated first (the 8253 is used for it)
+	kclock_calibrate_tsc();
+
+	//2026: the local APIC timer (if any) replaces the 8253 (whose interrupt stays masked)
+	if (lapic_init())
+	{
+		kclock_set_quantum(quantum);
+		irq_setmask_8259A((irq_mask_8259A | (1<<0)) & ~irq_devices_8259A);
+		return;
+	}
+
+	/* initialize 8253 clock to interrupt after the given quantum (2026: one-shot, see kclock_set_quantum_us()) */
+	outb(TIMER_MODE, TIMER_SEL0 | TIMER_INTTC | TIMER_16BIT);
 
 	//2017
 //	outb(TIMER_CNTR0, TIMER_DIV((1000/CLOCK_INTERVAL_IN_MS)) % 256);
@@ -46,7 +58,7 @@ kclock_start(uint8 quantum)
 	//cprintf("Timer Started: Counter0 Value = %d\n", cnt0 );
 
 	//cprintf("	Setup timer interrupts via 8259A\n");
-	irq_setmask_8259A(irq_mask_8259A & ~(1<<0));
+	irq_setmask_8259A(irq_mask_8259A & ~(1<<0) & ~irq_devices_8259A);
 	//cprintf("	unmasked timer interrupt\n");
 }
 
@@ -56,9 +68,22 @@ kclock_start(uint8 quantum)
 //Reset the CNT0 to the given quantum value without affecting the interrupt status
 void kclock_set_quantum(uint8 quantum_in_ms)
 {
-	if (IS_VALID_QUANTUM(quantum_in_ms))
+	kclock_set_quantum_us(quantum_in_ms * 1000);
+}
+
+//2026: the quantum in us
+uint32 kclock_quantum_us;
+void kclock_set_quantum_us(uint32 quantum_in_us)
+{
+	if (lapic_present)
 	{
-		kclock_write_cnt0_LSB_first(TIMER_DIV((1000/quantum_in_ms))) ;
+		kclock_quantum_us = quantum_in_us;
+		lapic_timer_oneshot(quantum_in_us);
+	}
+	else if (IS_VALID_QUANTUM(quantum_in_us / 1000))
+	{
+		kclock_quantum_us = quantum_in_us;
+		kclock_write_cnt0_LSB_first(quantum_in_us * (TIMER_FREQ / 1000) / 1000) ;
 		//uint16 cnt0 = kclock_read_cnt0_latch() ; //read after write to ensure it's set to the desired value
 	}
 	else
@@ -68,13 +93,20 @@ void kclock_set_quantum(uint8 quantum_in_ms)
 }
 //==============
 
+uint8 kclock_stopped;
+
 void
 kclock_resume(void)
 {
+	//2026: the local APIC timer isn't stopped in the kernel
+	if (lapic_present)
+		return;
+	kclock_stopped = 0;
+
 	uint16 cnt0 = kclock_read_cnt0() ;
 	//cprintf("Timer RESUMED: Counter0 Value = %x\n", cnt0 );
 
-	outb(TIMER_MODE, TIMER_SEL0 | TIMER_RATEGEN | TIMER_16BIT);
+	outb(TIMER_MODE, TIMER_SEL0 | TIMER_INTTC | TIMER_16BIT);
 	//2017: if the remaining time is small, then increase it a bit to avoid invoking the CLOCK INT
 	//		before returning back to the environment (this cause INT inside INT!!!) el7 :)
 	if (cnt0 < 10)
@@ -90,13 +122,18 @@ kclock_resume(void)
 //	cprintf("Timer RESUMED: Counter0 Value = %x\n", cnt0 );
 
 	//cprintf("	Setup timer interrupts via 8259A\n");
-	irq_setmask_8259A(irq_mask_8259A & ~(1<<0));
+	irq_setmask_8259A(irq_mask_8259A & ~(1<<0) & ~irq_devices_8259A);
 	//cprintf("	unmasked timer interrupt\n");
 }
 
 void
 kclock_stop(void)
 {
+	//2026: the local APIC timer isn't stopped in the kernel (the interrupts are disabled there)
+	if (lapic_present)
+		return;
+	kclock_stopped = 1;
+
 	//Read Status Register
 	//outb(TIMER_MODE, 0xe0);
 	//uint8 status = inb(TIMER_CNTR0) ;
@@ -105,7 +142,7 @@ kclock_stop(void)
 	//outb(TIMER_CNTR0, 0x00) ;
 	//outb(TIMER_CNTR0, 0x00) ;
 
-	outb(TIMER_MODE, TIMER_SEL0 | TIMER_RATEGEN | TIMER_16BIT);
+	outb(TIMER_MODE, TIMER_SEL0 | TIMER_INTTC | TIMER_16BIT);
 
 	//uint16 cnt0 = kclock_read_cnt0() ;
 
@@ -129,6 +166,82 @@ kclock_stop(void)
 
 }
 
+//2026: time (in us) remaining till the end of the current quantum (the 8253 should be stopped)
+uint32
+kclock_remaining_us(void)
+{
+	if (lapic_present)
+		return lapic_timer_remaining_us();
+
+	uint16 count = kclock_quantum_us * (TIMER_FREQ / 1000) / 1000;
+	uint16 cnt0 = kclock_read_cnt0();
+	//(it wraps around after the terminal count)
+	if (cnt0 > count)
+		return 0;
+	return cnt0 * 1000 / (TIMER_FREQ / 1000);
+}
+
+//2026: time (in us) elapsed since the start of the current quantum
+uint32
+kclock_elapsed_us(void)
+{
+	uint32 remaining = kclock_remaining_us();
+	return (remaining < kclock_quantum_us) ? kclock_quantum_us - remaining : 0;
+}
+
+//2026: the longest quantum
+uint32
+kclock_max_interval_ms(void)
+{
+	return lapic_present ? KCLOCK_LAPIC_MAX_INTERVAL_MS : QUANTUM_LIMIT - 1;
+}
+
+//2026: busy-wait for the given count of the 8253 counter 0 (its interrupt should be masked)
+void
+kclock_pit_wait(uint16 count)
+{
+	uint16 prev = count, cnt0;
+
+	outb(TIMER_MODE, TIMER_SEL0 | TIMER_INTTC | TIMER_16BIT);
+	kclock_write_cnt0_LSB_first(count);
+	//the counter goes down to 0 then wraps around
+	while ((cnt0 = kclock_read_cnt0_latch()) <= prev)
+	{
+		prev = cnt0;
+	}
+}
+
+//2026: TSC clock
+uint32 tsc_cycles_per_ms;
+static uint64 tsc_at_boot;
+
+void
+kclock_calibrate_tsc(void)
+{
+	uint32 eax, ebx, ecx, edx;
+	cpuid(1, &eax, &ebx, &ecx, &edx);
+	if ((edx & (1 << 4)) == 0)
+	{
+		cprintf("No TSC: the CPU times are not accounted\n");
+		return;
+	}
+	uint64 start = read_tsc();
+	kclock_pit_wait(TIMER_DIV(100));
+	tsc_cycles_per_ms = (read_tsc() - start) / 10;
+	tsc_at_boot = read_tsc();
+	cprintf("TSC: %d cycles/ms\n", tsc_cycles_per_ms);
+}
+
+//ns since the calibration
+uint64
+kclock_now_ns(void)
+{
+	if (tsc_cycles_per_ms == 0)
+		return 0;
+	uint64 cycles = read_tsc() - tsc_at_boot;
+	return (cycles / tsc_cycles_per_ms) * 1000000 + (cycles % tsc_cycles_per_ms) * 1000000 / tsc_cycles_per_ms;
+}
+
 //2017
 void
 kclock_write_cnt0_LSB_first(uint16 val)
@@ -42,6 +42,24 @@ void kclock_write_cnt0_LSB_first(uint16 val);
 //2018
 void kclock_set_quantum(uint8 quantum_in_ms);
 
+//2026: the clock interrupt fires once at the end of each quantum set by kclock_set_quantum_us():
+//the local APIC timer in one-shot mode if there's one (then the clock isn't stopped in the kernel:
+//kclock_stop() and kclock_resume() do nothing), else the 8253 counter 0 in one-shot mode
+//(interrupt on terminal count), then the longest quantum is QUANTUM_LIMIT - 1 ms.
+#define KCLOCK_LAPIC_MAX_INTERVAL_MS	250
+extern uint32 kclock_quantum_us;
+extern uint8 kclock_stopped;			//the 8253 is stopped by kclock_stop() (till kclock_resume())
+void kclock_set_quantum_us(uint32 quantum_in_us);
+uint32 kclock_elapsed_us(void);
+uint32 kclock_remaining_us(void);
+uint32 kclock_max_interval_ms(void);
+void kclock_pit_wait(uint16 count);
+
+//2026: monotonic clock in ns from the TSC, calibrated against the 8253 at boot (0 if there's no TSC)
+extern uint32 tsc_cycles_per_ms;
+void kclock_calibrate_tsc(void);
+uint64 kclock_now_ns(void);
+
 
 extern uint32 virtualTime;
 
@@ -0,0 +1,85 @@
+/* See COPYRIGHT for copyright information. */
+
+#include <inc/x86.h>
+#include <inc/stdio.h>
+#include <inc/memlayout.h>
+#include <inc/isareg.h>
+#include <inc/timerreg.h>
+#include <inc/trap.h>
+
+#include <kern/lapic.h>
+#include <kern/kclock.h>
+
+uint8 lapic_present;
+uint32 lapic_ticks_per_ms;	// timer ticks (after the divider) per ms, calibrated against the 8253
+
+static volatile uint32 *lapic = (volatile uint32 *) LAPIC_VA;
+
+static inline uint32 lapic_read(uint32 reg)
+{
+	return lapic[reg / 4];
+}
+
+static inline void lapic_write(uint32 reg, uint32 value)
+{
+	lapic[reg / 4] = value;
+	lapic[LAPIC_ID / 4];	// wait for the write to finish
+}
+
+//Count the timer ticks during 10 ms measured on the 8253 counter 0 (its interrupt should be masked)
+static uint32 lapic_calibrate(void)
+{
+	lapic_write(LAPIC_TICR, 0xFFFFFFFF);
+	kclock_pit_wait(TIMER_DIV(100));
+	uint32 ticks = 0xFFFFFFFF - lapic_read(LAPIC_TCCR);
+	lapic_write(LAPIC_TICR, 0);
+	return ticks / 10;
+}
+
+//Enable the local APIC (if any) and calibrate its timer. Returns 0 if there's no local APIC
+int lapic_init(void)
+{
+	uint32 eax, ebx, ecx, edx;
+	cpuid(1, &eax, &ebx, &ecx, &edx);
+	if ((edx & (1 << 9)) == 0)
+		return 0;
+
+	lapic_write(LAPIC_SVR, LAPIC_ENABLE | T_LAPIC_SPURIOUS);
+	//the 8259A interrupts come through LINT0
+	lapic_write(LAPIC_LINT0, LAPIC_EXTINT);
+	lapic_write(LAPIC_LINT1, LAPIC_NMI);
+	lapic_write(LAPIC_ERROR, LAPIC_MASKED);
+	lapic_write(LAPIC_ESR, 0);
+	lapic_write(LAPIC_ESR, 0);
+	lapic_write(LAPIC_TPR, 0);
+	lapic_write(LAPIC_EOI, 0);
+
+	lapic_write(LAPIC_TDCR, LAPIC_DIV_16);
+	lapic_write(LAPIC_TIMER, LAPIC_MASKED | T_LAPIC_TIMER);
+	lapic_ticks_per_ms = lapic_calibrate();
+	if (lapic_ticks_per_ms == 0)
+		return 0;
+	lapic_write(LAPIC_TIMER, T_LAPIC_TIMER);		//one-shot
+
+	lapic_present = 1;
+	cprintf("Local APIC timer: %d ticks/ms\n", lapic_ticks_per_ms);
+	return 1;
+}
+
+void lapic_eoi(void)
+{
+	lapic_write(LAPIC_EOI, 0);
+}
+
+//Start the timer to interrupt once after the given quantum
+void lapic_timer_oneshot(uint32 quantum_in_us)
+{
+	uint32 ticks = (quantum_in_us / 1000) * lapic_ticks_per_ms + (quantum_in_us % 1000) * lapic_ticks_per_ms / 1000;
+	lapic_write(LAPIC_TICR, MAX(ticks, 1));
+}
+
+uint32 lapic_timer_remaining_us(void)
+{
+	uint32 ticks = lapic_read(LAPIC_TCCR);
+	return (ticks / lapic_ticks_per_ms) * 1000 + (ticks % lapic_ticks_per_ms) * 1000 / lapic_ticks_per_ms;
+}
@@ -0,0 +1,47 @@
+/* See COPYRIGHT for copyright information. */
+
+#ifndef FOS_KERN_LAPIC_H
+#define FOS_KERN_LAPIC_H
+#ifndef FOS_KERNEL
+# error "This is a FOS kernel header; user programs should not #include it"
+#endif
+
+#include <inc/types.h>
+
+//2026: local APIC timer
+//======================
+//When the CPU has a local APIC, its timer is used (in one-shot mode) for the CPU quantum instead
+//of the 8253 (see kclock_set_quantum_us()). The 8259A still delivers the device IRQs through the
+//LINT0 pin (ExtINT). The registers are mapped at LAPIC_VA (see initialize_kernel_VM()).
+
+#define LAPIC_PHYS_BASE		0xFEE00000
+
+//Registers (offsets in bytes)
+#define LAPIC_ID		0x020
+#define LAPIC_VER		0x030
+#define LAPIC_TPR		0x080	// task priority
+#define LAPIC_EOI		0x0B0
+#define LAPIC_SVR		0x0F0	// spurious interrupt vector
+#define		LAPIC_ENABLE	0x00000100
+#define LAPIC_ESR		0x280	// error status
+#define LAPIC_TIMER		0x320	// local vector table: timer
+#define LAPIC_LINT0		0x350	// local vector table: LINT0
+#define LAPIC_LINT1		0x360	// local vector table: LINT1
+#define LAPIC_ERROR		0x370	// local vector table: error
+#define		LAPIC_MASKED	0x00010000
+#define		LAPIC_NMI		0x00000400
+#define		LAPIC_EXTINT	0x00000700
+#define LAPIC_TICR		0x380	// timer initial count
+#define LAPIC_TCCR		0x390	// timer current count
+#define LAPIC_TDCR		0x3E0	// timer divide configuration
+#define		LAPIC_DIV_16	0x3
+
+extern uint8 lapic_present;
+extern uint32 lapic_ticks_per_ms;
+
+int lapic_init(void);
+void lapic_eoi(void);
+void lapic_timer_oneshot(uint32 quantum_in_us);
+uint32 lapic_timer_remaining_us(void);
+
+#endif /* !FOS_KERN_LAPIC_H */
@@ -21,6 +21,7 @@ FUNCTIONS:	to_physical_address, get_frame_info, tlb_invalidate
 
 #include <kern/kclock.h>
 #include <kern/user_environment.h>
+#include <kern/lapic.h>
 #include <kern/sched.h>
 #include <kern/kheap.h>
 #include <kern/file_manager.h>
@@ -37,6 +38,7 @@ inline uint32 env_table_ws_get_virtual_address(struct Env* e, uint32 entry_index
 inline uint32 env_table_ws_get_time_stamp(struct Env* e, uint32 entry_index);
 inline uint32 env_table_ws_is_entry_empty(struct Env* e, uint32 entry_index);
 void env_table_ws_print(struct Env *curenv);
+extern void page_fault_handler(struct Env * curenv, uint32 fault_va);
 
 inline uint32 pd_is_table_used(struct Env *e, uint32 virtual_address);
 inline void pd_set_table_unused(struct Env *e, uint32 virtual_address);
@@ -51,8 +53,9 @@ uint32 phys_page_directory;		// Physical address of boot time page directory
 char* ptr_free_mem;	// Pointer to next byte of free mem
 
 struct Frame_Info* frames_info;		// Virtual address of physical frames_info array
-struct Frame_Info* disk_frames_info;		// Virtual address of physical frames_info array
+uint32* disk_frames_bitmap;				// 2026: used/free bit of each page file slot (see file_manager.c)
 struct Linked_List free_frame_list;	// Free list of physical frames_info
+uint32 frames_next_uninitialized;		// 2026: frames [frames_next_uninitialized, number_of_frames) are free but not in the list yet
 struct Linked_List modified_frame_list;
 
 
@@ -130,16 +133,17 @@ void initialize_kernel_VM()
 	uint32 array_size;
 	array_size = number_of_frames * sizeof(struct Frame_Info) ;
 	frames_info = boot_allocate_space(array_size, PAGE_SIZE);
-	memset(frames_info, 0, array_size);
+	//2026: (the frames_info of the free frames are cleared when they're put in the free frame list)
 
 	//2016: Not valid any more since the RAM size exceed the 64 MB limit. This lead to the
 	// 		size of "frames_info" can exceed the 4 MB space for "READ_ONLY_FRAMES_INFO"
 	//boot_map_range(ptr_page_directory, READ_ONLY_FRAMES_INFO, array_size, STATIC_KERNEL_PHYSICAL_ADDRESS(frames_info),PERM_USER) ;
 
 
-	uint32 disk_array_size = PAGES_PER_FILE * sizeof(struct Frame_Info);
-	disk_frames_info = boot_allocate_space(disk_array_size , PAGE_SIZE);
-	memset(disk_frames_info , 0, disk_array_size);
+	//2026: the page file size is discovered from the disk, so is the size of its slots bitmap
+	uint32 disk_array_size = ROUNDUP(pf_discover_size(), 32) / 8;
+	disk_frames_bitmap = boot_allocate_space(disk_array_size , PAGE_SIZE);
+	//2026: (it's initialized by chunks, see initialize_disk_page_file())
 
 	// This allows the kernel & user to access any page table entry using a
 	// specified VA for each: VPT for kernel and UVPT for User.
@@ -155,6 +159,7 @@ void initialize_kernel_VM()
 
 	// LAB 3: Your code here.
 	cprintf("Max Envs = %d\n",NENV);
+	static_assert(NENV * sizeof(struct Env) <= PTSIZE/4);
 	int envs_size = NENV * sizeof(struct Env) ;
 
 	//allocate space for "envs" array aligned on 4KB boundary
@@ -183,6 +188,9 @@ void initialize_kernel_VM()
 	// Check that the initial page directory has been set up correctly.
 	check_boot_pgdir();
 
+	//2026: the local APIC registers (uncached)
+	boot_map_range(ptr_page_directory, LAPIC_VA, PAGE_SIZE, LAPIC_PHYS_BASE, PERM_WRITEABLE | PTE_PCD | PTE_PWT) ;
+
 
 	/*
 	NOW: Turn off the segmentation by setting the segments' base to 0, and
@@ -343,6 +351,10 @@ void initialize_paging()
 	LIST_INIT(&free_frame_list);
 	LIST_INIT(&modified_frame_list);
 
+	//2026: the free frames of the extended memory are initialized later (see initialize_frames_chunk()),
+	//		so only the frames_info of the others are cleared here
+	memset(frames_info, 0, ROUNDUP(STATIC_KERNEL_PHYSICAL_ADDRESS(ptr_free_mem), PAGE_SIZE) / PAGE_SIZE * sizeof(struct Frame_Info));
+
 	frames_info[0].references = 1;
 	frames_info[1].references = 1;
 	frames_info[2].references = 1;
@@ -378,15 +390,35 @@ void initialize_paging()
 		frames_info[i].references = 1;
 	}
 
-	for (i = range_end/PAGE_SIZE ; i < number_of_frames; i++)
-	{
-		initialize_frame_info(&(frames_info[i]));
+	//2026: only a small pool is initialized now
+	frames_next_uninitialized = range_end/PAGE_SIZE;
+	initialize_frames_chunk(FRAMES_INIT_POOL);
 
-		//frames_info[i].references = 0;
-		LIST_INSERT_HEAD(&free_frame_list, &frames_info[i]);
+	initialize_disk_page_file();
+}
+
+//2026: Puts the next "count" free frames (at most) not initialized yet in the free frame list.
+//Returns the # initialized frames
+uint32 initialize_frames_chunk(uint32 count)
+{
+	uint32 end = MIN(frames_next_uninitialized + count, number_of_frames);
+	uint32 n = end - frames_next_uninitialized;
+
+	for (; frames_next_uninitialized < end; frames_next_uninitialized++)
+	{
+		initialize_frame_info(&(frames_info[frames_next_uninitialized]));
+		LIST_INSERT_HEAD(&free_frame_list, &frames_info[frames_next_uninitialized]);
 	}
+	return n;
+}
 
-	initialize_disk_page_file();
+//2026: Does one step of the deferred initializations (a chunk of frames and a chunk of the page
+//file bitmap). Called while the kernel is idle. Returns 0 once everything is initialized
+uint32 initialize_deferred_chunk()
+{
+	uint32 nFrames = initialize_frames_chunk(FRAMES_INIT_CHUNK);
+	uint32 bitmapChunk = pf_initialize_bitmap_chunk();
+	return nFrames > 0 || bitmapChunk;
 }
 
 //
@@ -420,6 +452,11 @@ int allocate_frame(struct Frame_Info **ptr_frame_info)
 {
 	*ptr_frame_info = LIST_FIRST(&free_frame_list);
 	int c = 0;
+	//2026: initialize the next chunk of free frames (if any)
+	if (*ptr_frame_info == NULL && initialize_frames_chunk(FRAMES_INIT_CHUNK) > 0)
+	{
+		*ptr_frame_info = LIST_FIRST(&free_frame_list);
+	}
 	if (*ptr_frame_info == NULL)
 	{
 		panic("ERROR: Kernel run out of memory... allocate_frame cannot find a free frame.\n");
@@ -901,6 +938,261 @@ void moveMem(struct Env* e, uint32 src_virtual_address, uint32 dst_virtual_addre
 	// or main memory
 }
 
+//==================================================================================================
+//======================================= 2026: MEMORY HINTS =======================================
+//==================================================================================================
+
+//Loads the given pages (only those found in the page file, or lazily loaded from the program image,
+//and not already resident) into the free entries of the WS of "e" using batched disk reads.
+//Should be called while e's directory is loaded. Returns the # loaded pages
+uint32 env_page_ws_prefetch(struct Env* e, uint32* virtual_addresses, uint32 count)
+{
+	uint32 vas[PF_BATCH_MAX_COUNT];
+	uint32 n = 0, nLoaded = 0;
+	uint32 wsSize = env_page_ws_get_size(e);
+	int i;
+
+	for (i = 0; i < count && n < PF_BATCH_MAX_COUNT && wsSize + nLoaded < e->page_WS_max_size; i++)
+	{
+		uint32 va = ROUNDDOWN(virtual_addresses[i], PAGE_SIZE);
+		uint32 *ptr_page_table = NULL;
+
+		if (calculate_free_frames() <= PREFETCH_RESERVED_FRAMES)
+			break;
+		//already resident or not in the page file (e.g. heap not allocated yet)
+		if (get_frame_info(e->env_page_directory, (void*)va, &ptr_page_table) != NULL)
+			continue;
+		uint8 inPageFile = (pf_get_env_page_dfn(e, va) != 0);
+		if (!inPageFile && !env_page_is_lazy(e, va))
+			continue;
+
+		//(a page of the shared text is mapped from its shared frame)
+		int sharedRet = inPageFile ? E_PAGE_NOT_EXIST_IN_PF : env_page_map_shared(e, va);
+		if (sharedRet == E_NO_MEM)
+			break;
+		uint8 shared = (sharedRet == 0);
+		if (!shared)
+		{
+			struct Frame_Info *ptr_frame_info = NULL;
+			allocate_frame(&ptr_frame_info);
+			loadtime_map_frame(e->env_page_directory, ptr_frame_info, (void*)va, PERM_USER | PERM_WRITEABLE);
+		}
+
+		//add it in the first empty entry after the last added one
+		while (!env_page_ws_is_entry_empty(e, e->page_last_WS_index))
+		{
+			e->page_last_WS_index = (e->page_last_WS_index + 1) % (e->page_WS_max_size);
+		}
+		env_page_ws_set_entry(e, e->page_last_WS_index, va);
+		e->page_last_WS_index = (e->page_last_WS_index + 1) % (e->page_WS_max_size);
+
+		if (inPageFile)
+			vas[n++] = va;
+		else if (!shared)
+			env_page_lazy_fill(e, va);
+		nLoaded++;
+	}
+
+	if (n > 0)
+	{
+		pf_read_env_pages_batch(e, vas, n);
+	}
+	return nLoaded;
+}
+
+//Called after a page fault at "fault_va": if it lies inside a MADV_SEQUENTIAL range,
+//the next MADV_READAHEAD_PAGES pages of the range are loaded with it
+void env_page_ws_readahead(struct Env* e, uint32 fault_va)
+{
+	int i;
+	for (i = 0; i < MAX_MEM_ADVICES; i++)
+	{
+		struct MemAdvice* adv = &(e->memAdvices[i]);
+		if (adv->advice != MADV_SEQUENTIAL || fault_va < adv->start || fault_va >= adv->end)
+			continue;
+
+		uint32 vas[MADV_READAHEAD_PAGES];
+		uint32 n = 0;
+		uint32 va = ROUNDDOWN(fault_va, PAGE_SIZE) + PAGE_SIZE;
+		for (; n < MADV_READAHEAD_PAGES && va < adv->end; va += PAGE_SIZE)
+		{
+			vas[n++] = va;
+		}
+		env_page_ws_prefetch(e, vas, n);
+		return;
+	}
+}
+
+static inline int mem_hint_check_range(uint32 virtual_address, uint32 size, uint32* start, uint32* end)
+{
+	*start = ROUNDDOWN(virtual_address, PAGE_SIZE);
+	*end = ROUNDUP(virtual_address + size, PAGE_SIZE);
+	if (size == 0 || *end <= *start || *end > USER_TOP)
+		return E_INVAL;
+	return 0;
+}
+
+//Drops the advices of all ranges overlapping [start, end)
+static void mem_hint_remove_advices(struct Env* e, uint32 start, uint32 end)
+{
+	int i;
+	for (i = 0; i < MAX_MEM_ADVICES; i++)
+	{
+		struct MemAdvice* adv = &(e->memAdvices[i]);
+		if (adv->advice != MADV_NORMAL && adv->start < end && start < adv->end)
+		{
+			adv->advice = MADV_NORMAL;
+		}
+	}
+}
+
+//Removes the resident (not locked) pages of the given range from the WS of "e",
+//writing the modified ones back to the page file first
+static void mem_hint_drop_pages(struct Env* e, uint32 start, uint32 end)
+{
+	int i;
+	for (i = 0; i < e->page_WS_max_size; i++)
+	{
+		if (env_page_ws_is_entry_empty(e, i))
+			continue;
+		uint32 va = env_page_ws_get_virtual_address(e, i);
+		if (va < start || va >= end)
+			continue;
+
+		uint32 perm = pt_get_page_permissions(e, va);
+		if (perm & PERM_LOCKED)
+			continue;
+
+		uint32 *ptr_page_table = NULL;
+		struct Frame_Info* ptr_frame_info = get_frame_info(e->env_page_directory, (void*)va, &ptr_page_table);
+		if (ptr_frame_info != NULL)
+		{
+			if (perm & PERM_MODIFIED)
+			{
+				pf_update_env_page(e, (void*)va, ptr_frame_info);
+			}
+			unmap_frame(e->env_page_directory, (void*)va);
+		}
+		env_page_ws_clear_entry(e, i);
+	}
+}
+
+//Applies the given access advice (MADV_*) on the range [virtual_address, virtual_address + size)
+//of "e". Should be called while e's directory is loaded.
+//SEQUENTIAL/RANDOM advices are kept per range (at most MAX_MEM_ADVICES ranges), a new advice replaces
+//the ones of any overlapping range. WILLNEED/DONTNEED are applied at once and not kept.
+int madviseMem(struct Env* e, uint32 virtual_address, uint32 size, int advice)
+{
+	uint32 start, end, va;
+	int i;
+
+	if (mem_hint_check_range(virtual_address, size, &start, &end) != 0)
+		return E_INVAL;
+
+	switch (advice)
+	{
+	case MADV_NORMAL:
+		mem_hint_remove_advices(e, start, end);
+		return 0;
+
+	case MADV_SEQUENTIAL:
+	case MADV_RANDOM:
+		mem_hint_remove_advices(e, start, end);
+		for (i = 0; i < MAX_MEM_ADVICES; i++)
+		{
+			if (e->memAdvices[i].advice == MADV_NORMAL)
+			{
+				e->memAdvices[i].start = start;
+				e->memAdvices[i].end = end;
+				e->memAdvices[i].advice = advice;
+				return 0;
+			}
+		}
+		return E_NO_MEM;
+
+	case MADV_WILLNEED:
+	{
+		uint32 vas[PF_BATCH_MAX_COUNT];
+		uint32 n = 0;
+		for (va = start; va < end; va += PAGE_SIZE)
+		{
+			vas[n++] = va;
+			if (n == PF_BATCH_MAX_COUNT || va + PAGE_SIZE >= end)
+			{
+				env_page_ws_prefetch(e, vas, n);
+				n = 0;
+				if (env_page_ws_get_size(e) == e->page_WS_max_size)
+					break;
+			}
+		}
+		return 0;
+	}
+
+	case MADV_DONTNEED:
+		mem_hint_drop_pages(e, start, end);
+		return 0;
+	}
+	return E_INVAL;
+}
+
+//Pins the pages of the given range in the WS of "e" (faulting them in if needed) so they are
+//never selected for replacement nor removed on suspension.
+//At most half of the WS can be locked, otherwise E_NO_MEM is returned and nothing is locked
+int mlockMem(struct Env* e, uint32 virtual_address, uint32 size)
+{
+	uint32 start, end, va;
+	uint32 nNewLocked = 0;
+
+	if (mem_hint_check_range(virtual_address, size, &start, &end) != 0)
+		return E_INVAL;
+
+	for (va = start; va < end; va += PAGE_SIZE)
+	{
+		uint32 perm = pt_get_page_permissions(e, va);
+		if (perm & PERM_LOCKED)
+			continue;
+		if ((perm & PERM_PRESENT) == 0 && pf_get_env_page_dfn(e, va) == 0
+				&& !(va < USTACKTOP && va >= USTACKBOTTOM) && !env_page_is_lazy(e, va))
+			return E_PAGE_NOT_EXIST_IN_PF;
+		nNewLocked++;
+	}
+	if (e->nLockedPages + nNewLocked > e->page_WS_max_size / 2)
+		return E_NO_MEM;
+
+	for (va = start; va < end; va += PAGE_SIZE)
+	{
+		uint32 perm = pt_get_page_permissions(e, va);
+		if (perm & PERM_LOCKED)
+			continue;
+		if ((perm & PERM_PRESENT) == 0)
+		{
+			page_fault_handler(e, va);
+		}
+		pt_set_page_permissions(e, va, PERM_LOCKED, 0);
+		e->nLockedPages++;
+	}
+	return 0;
+}
+
+//Unpins the locked pages of the given range of "e"
+int munlockMem(struct Env* e, uint32 virtual_address, uint32 size)
+{
+	uint32 start, end, va;
+
+	if (mem_hint_check_range(virtual_address, size, &start, &end) != 0)
+		return E_INVAL;
+
+	for (va = start; va < end; va += PAGE_SIZE)
+	{
+		if (pt_get_page_permissions(e, va) & PERM_LOCKED)
+		{
+			pt_set_page_permissions(e, va, 0, PERM_LOCKED);
+			e->nLockedPages--;
+		}
+	}
+	return 0;
+}
+
 //==================================================================================================
 
 //==================================================================================================
@@ -971,6 +1263,8 @@ struct freeFramesCounters calculate_available_frames()
 		else
 			totalFreeUnBuffered++ ;
 	}
+	//2026: the free frames not initialized yet
+	totalFreeUnBuffered += number_of_frames - frames_next_uninitialized;
 
 
 
@@ -991,7 +1285,8 @@ struct freeFramesCounters calculate_available_frames()
 // calculate_free_frames:
 uint32 calculate_free_frames()
 {
-	return LIST_SIZE(&free_frame_list);
+	//2026: (the free frames not initialized yet included)
+	return LIST_SIZE(&free_frame_list) + (number_of_frames - frames_next_uninitialized);
 }
 
 
@@ -57,6 +57,14 @@ uint32 isKHeapPlacementStrategyWORSTFIT();
 
 //Functions
 uint32 calculate_free_frames();
+
+//2026: deferred initialization of the frames: only FRAMES_INIT_POOL free frames are put in the
+//free frame list at boot, the others by chunks of FRAMES_INIT_CHUNK when the list becomes empty
+//or when the kernel is idle (see initialize_deferred_chunk())
+#define FRAMES_INIT_POOL	1024
+#define FRAMES_INIT_CHUNK	1024
+uint32 initialize_frames_chunk(uint32 count);
+uint32 initialize_deferred_chunk();
 //***********************************
 
 struct freeFramesCounters
@@ -69,7 +77,7 @@ struct Env;
 extern char ptr_stack_top[], ptr_stack_bottom[];
 
 extern struct Frame_Info* frames_info;
-extern struct Frame_Info* disk_frames_info;		// Virtual address of physical frames_info array
+extern uint32* disk_frames_bitmap;
 extern struct Linked_List free_frame_list;	// Free list of physical frames
 extern struct Linked_List modified_frame_list;	// Free list of physical frames
 extern uint32 number_of_frames;
@@ -122,6 +130,9 @@ static inline struct Frame_Info* to_frame_info(uint32 physical_address)
 void freeMem(struct Env* e, uint32 virtual_address, uint32 size);
 void allocateMem(struct Env* e, uint32 virtual_address, uint32 size);
 void moveMem(struct Env* e, uint32 src_virtual_address, uint32 dst_virtual_address, uint32 size);
+int madviseMem(struct Env* e, uint32 virtual_address, uint32 size, int advice);
+int mlockMem(struct Env* e, uint32 virtual_address, uint32 size);
+int munlockMem(struct Env* e, uint32 virtual_address, uint32 size);
 uint32 calculate_required_frames(uint32* ptr_page_directory, uint32 start_virtual_address, uint32 size);
 struct freeFramesCounters calculate_available_frames();
 void trim_all_environments();
@@ -137,6 +148,12 @@ inline uint32 env_page_ws_get_time_stamp(struct Env* e, uint32 entry_index);
 inline uint32 env_page_ws_is_entry_empty(struct Env* e, uint32 entry_index);
 void env_page_ws_print(struct Env *curenv);
 
+//2026: loading several pages into the WS at once
+#define PREFETCH_RESERVED_FRAMES 64	//don't prefetch when the free frames go below this
+#define MADV_READAHEAD_PAGES 4		//# pages read ahead after a fault inside a MADV_SEQUENTIAL range
+uint32 env_page_ws_prefetch(struct Env* e, uint32* virtual_addresses, uint32 count);
+void env_page_ws_readahead(struct Env* e, uint32 fault_va);
+
 
 //page buffering functions
 void bufferList_add_page(struct Linked_List* bufferList, struct Frame_Info *ptr_frame_info);
@@ -0,0 +1,138 @@
+/* See COPYRIGHT for copyright information. */
+
+#include <inc/stdio.h>
+#include <inc/string.h>
+#include <inc/assert.h>
+#include <inc/mmu.h>
+
+#include <kern/pgtrace.h>
+#include <kern/console.h>
+#include <kern/memory_manager.h>
+
+#define PGTRACE_MAX_ENVS 16		//# envs whose name & WS size are reported in the dump
+
+struct PgTraceRecord pgtrace_buffer[PGTRACE_BUFFER_SIZE];
+uint32 pgtrace_count;			//total # records since the trace started (including overwritten ones)
+uint32 pgtrace_enabled;
+int32 pgtrace_env_id;			//traced env (PGTRACE_ALL_ENVS for all of them)
+
+struct
+{
+	int32 env_id;
+	char prog_name[PROGNAMELEN];
+	uint32 ws_size;
+} pgtrace_envs[PGTRACE_MAX_ENVS];
+uint32 pgtrace_num_envs;
+
+void pgtrace_start(int32 env_id)
+{
+	pgtrace_count = 0;
+	pgtrace_num_envs = 0;
+	pgtrace_env_id = env_id;
+	pgtrace_enabled = 1;
+}
+
+void pgtrace_stop()
+{
+	pgtrace_enabled = 0;
+}
+
+uint32 isPgTraceEnabled()
+{
+	return pgtrace_enabled;
+}
+
+static void pgtrace_add(struct Env* e, uint8 type, uint32 va, uint8 write)
+{
+	int i;
+	if (pgtrace_env_id != PGTRACE_ALL_ENVS && e->env_id != pgtrace_env_id)
+		return;
+
+	for (i = 0; i < pgtrace_num_envs; i++)
+	{
+		if (pgtrace_envs[i].env_id == e->env_id)
+			break;
+	}
+	if (i == pgtrace_num_envs && pgtrace_num_envs < PGTRACE_MAX_ENVS)
+	{
+		pgtrace_envs[i].env_id = e->env_id;
+		strncpy(pgtrace_envs[i].prog_name, e->prog_name, PROGNAMELEN);
+		pgtrace_envs[i].ws_size = e->page_WS_max_size;
+		pgtrace_num_envs++;
+	}
+
+	struct PgTraceRecord* rec = &pgtrace_buffer[pgtrace_count % PGTRACE_BUFFER_SIZE];
+	rec->env_id = e->env_id;
+	rec->tick = e->nClocks;
+	rec->va = ROUNDDOWN(va, PAGE_SIZE);
+	rec->type = type;
+	rec->write = write;
+	pgtrace_count++;
+}
+
+void pgtrace_record_fault(struct Env* e, uint32 fault_va, uint32 isWrite)
+{
+	pgtrace_add(e, PGTRACE_FAULT, fault_va, isWrite ? 1 : 0);
+}
+
+void pgtrace_record_sample(struct Env* e, uint32 va, uint32 perm)
+{
+	pgtrace_add(e, PGTRACE_SAMPLE, va, (perm & PERM_MODIFIED) ? 1 : 0);
+}
+
+//Records the USED pages of the WS of the given env without clearing their USED bits
+//(which the CLOCK algorithms rely on to select their victims)
+void pgtrace_sample_ws(struct Env* e)
+{
+	int i;
+	for (i = 0; i < e->page_WS_max_size; i++)
+	{
+		if (e->ptr_pageWorkingSet[i].empty == 1)
+			continue;
+		uint32 page_va = e->ptr_pageWorkingSet[i].virtual_address;
+		uint32 perm = pt_get_page_permissions(e, page_va);
+		if (perm & PERM_USED)
+			pgtrace_record_sample(e, page_va, perm);
+	}
+}
+
+static void pgtrace_serial_printf(const char *fmt, ...)
+{
+	char line[80];
+	va_list ap;
+	int i;
+
+	va_start(ap, fmt);
+	vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+	for (i = 0; line[i] != '\0'; i++)
+		serial_putc(line[i]);
+}
+
+//Writes the recorded trace (oldest record first) of the given env (or PGTRACE_ALL_ENVS)
+//to the serial port, one record per line:
+//	#FOSTRACE <# records> <# dropped records>
+//	#ENV <env id> <program name> <WS size>
+//	<F|U> <env id> <tick> <va> <write>
+void pgtrace_dump(int32 env_id)
+{
+	uint32 first = (pgtrace_count > PGTRACE_BUFFER_SIZE) ? pgtrace_count - PGTRACE_BUFFER_SIZE : 0;
+	uint32 i, n = 0;
+
+	pgtrace_serial_printf("#FOSTRACE %d %d\n", pgtrace_count - first, first);
+	for (i = 0; i < pgtrace_num_envs; i++)
+	{
+		if (env_id == PGTRACE_ALL_ENVS || pgtrace_envs[i].env_id == env_id)
+			pgtrace_serial_printf("#ENV %d %s %d\n", pgtrace_envs[i].env_id, pgtrace_envs[i].prog_name, pgtrace_envs[i].ws_size);
+	}
+	for (i = first; i < pgtrace_count; i++)
+	{
+		struct PgTraceRecord* rec = &pgtrace_buffer[i % PGTRACE_BUFFER_SIZE];
+		if (env_id != PGTRACE_ALL_ENVS && rec->env_id != env_id)
+			continue;
+		pgtrace_serial_printf("%c %d %d %x %d\n", rec->type, rec->env_id, rec->tick, rec->va, rec->write);
+		n++;
+	}
+	pgtrace_serial_printf("#END\n");
+	cprintf("%d trace records written to the serial port (%d older ones were overwritten)\n", n, first);
+}
@@ -0,0 +1,45 @@
+/* See COPYRIGHT for copyright information. */
+
+#ifndef FOS_KERN_PGTRACE_H
+#define FOS_KERN_PGTRACE_H
+#ifndef FOS_KERNEL
+# error "This is a FOS kernel header; user programs should not #include it"
+#endif
+
+#include <inc/types.h>
+#include <inc/environment_definitions.h>
+
+//2026: page-reference trace
+//==========================
+//Records, in a ring buffer, the faulted VAs and the pages found USED at each clock tick
+//(sampled by update_WS_time_stamps() under LRU, else by pgtrace_sample_ws() which leaves the
+//USED bits to the CLOCK algorithms). The buffer is dumped as text over the serial port
+//and replayed on the host by tools/pgreplay to compare the replacement algorithms.
+
+#define PGTRACE_BUFFER_SIZE		8192	//# records kept (the oldest ones are overwritten)
+
+//record types (also used as the first char of each dumped line)
+#define PGTRACE_FAULT			'F'		//page fault at va (write = faulting access was a write)
+#define PGTRACE_SAMPLE			'U'		//page found USED at a tick (write = page is MODIFIED)
+
+//Env filter meaning "all envs"
+#define PGTRACE_ALL_ENVS		0
+
+struct PgTraceRecord
+{
+	int32 env_id;
+	uint32 tick;		//env's nClocks when recorded
+	uint32 va;
+	uint8 type;
+	uint8 write;
+};
+
+void pgtrace_start(int32 env_id);
+void pgtrace_stop();
+uint32 isPgTraceEnabled();
+void pgtrace_record_fault(struct Env* e, uint32 fault_va, uint32 isWrite);
+void pgtrace_record_sample(struct Env* e, uint32 va, uint32 perm);
+void pgtrace_sample_ws(struct Env* e);
+void pgtrace_dump(int32 env_id);
+
+#endif /* !FOS_KERN_PGTRACE_H */
@@ -8,6 +8,8 @@
 // Current IRQ mask.
 // Initial IRQ mask has interrupt 2 enabled (for slave 8259A).
 uint16 irq_mask_8259A = 0xFFFF & ~(1<<IRQ_SLAVE);
+//2026: device IRQs (other than the clock) unmasked whenever the clock is resumed
+uint16 irq_devices_8259A = 0;
 static bool didinit;
 
 /* Initialize the 8259A interrupt controllers. */
@@ -83,3 +85,20 @@ irq_setmask_8259A(uint16 mask)
 	//cprintf("\n");
 }
 
+//2026: unmask the given device IRQ now and each time the clock is resumed (see kclock_resume())
+void
+irq_enable_device_8259A(int irq)
+{
+	irq_devices_8259A |= (1 << irq);
+	if (irq >= 8)
+		irq_devices_8259A |= (1 << IRQ_SLAVE);
+	irq_setmask_8259A(irq_mask_8259A & ~irq_devices_8259A);
+}
+
+//The master works in automatic EOI mode, but the slave (IRQs 8-15) needs an explicit EOI
+void
+irq_eoi_8259A(int irq)
+{
+	if (irq >= 8)
+		outb(IO_PIC2, 0x20);
+}
@@ -22,8 +22,11 @@
 #include <inc/x86.h>
 
 extern uint16 irq_mask_8259A;
+extern uint16 irq_devices_8259A;
 void pic_init(void);
 void irq_setmask_8259A(uint16 mask);
+void irq_enable_device_8259A(int irq);
+void irq_eoi_8259A(int irq);
 
 #endif // !__ASSEMBLER__
 
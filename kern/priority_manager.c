@@ -3,11 +3,31 @@
 #include <inc/assert.h>
 #include <kern/helpers.h>
 #include <kern/user_environment.h>
+#include <kern/sched.h>
 
+//2026: set the priority of the given env, for both:
+//	- the memory: its page WS is doubled (if full) for PRIORITY_HIGH, once only for PRIORITY_ABOVENORMAL,
+//	  and halved for PRIORITY_LOW (removing its extra pages), only if its pages fit for PRIORITY_BELOWNORMAL
+//	- the CPU: its initial MLFQ level and its weight in the RR/CFS (see sched_set_priority())
 void set_program_priority(struct Env* env, int priority)
 {
-	//TODO: [PROJECT 2022 - BONUS4] Change WS Size according to Program Priority
-
-	panic("This function is not implemented yet\n");
+	if (env == NULL || priority < PRIORITY_LOW || priority > PRIORITY_HIGH)
+		return;
 
+	switch (priority)
+	{
+	case PRIORITY_LOW:
+		half_WS_Size(env, 1);
+		break;
+	case PRIORITY_BELOWNORMAL:
+		half_WS_Size(env, 0);
+		break;
+	case PRIORITY_ABOVENORMAL:
+		double_WS_Size(env, 1);
+		break;
+	case PRIORITY_HIGH:
+		double_WS_Size(env, 0);
+		break;
+	}
+	sched_set_priority(env, priority);
 }
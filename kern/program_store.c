@@ -0,0 +1,110 @@
+/* See COPYRIGHT for copyright information. */
+
+#include <inc/stdio.h>
+#include <inc/string.h>
+#include <inc/assert.h>
+#include <inc/disk.h>
+
+#include <kern/program_store.h>
+#include <kern/disk_queue.h>
+#include <kern/kheap.h>
+
+//the index of the store (read once at boot)
+static union
+{
+	struct ProgramStoreHeader header;
+	struct ProgramStoreEntry entries[PS_MAX_PROGRAMS + 1];
+} ps_index;
+
+static uint32 ps_num_programs;
+
+//Reads the index of the store (if any) from the disk
+void ps_init()
+{
+	ps_num_programs = 0;
+	if (dq_read(0, PROGRAM_STORE_START_SECTOR, &ps_index, PS_INDEX_SECTORS) != 0
+			|| ps_index.header.magic != PS_MAGIC || ps_index.header.count > PS_MAX_PROGRAMS)
+	{
+		cprintf("Program store: not found\n");
+		return;
+	}
+	ps_num_programs = ps_index.header.count;
+	cprintf("Program store: %d programs (%d KB) at sector %d\n", ps_num_programs,
+			ps_index.header.nsectors * SECTSIZE / 1024, PROGRAM_STORE_START_SECTOR);
+}
+
+uint32 ps_count()
+{
+	return ps_num_programs;
+}
+
+struct ProgramStoreEntry* ps_get(uint32 index)
+{
+	if (index >= ps_num_programs)
+		return NULL;
+	return &(ps_index.entries[index + 1]);
+}
+
+struct ProgramStoreEntry* ps_find(const char* name)
+{
+	int i;
+	if (name == NULL)
+		return NULL;
+	for (i = 0; i < ps_num_programs; i++)
+	{
+		if (strncmp(ps_index.entries[i + 1].name, name, PS_NAME_LEN) == 0)
+			return &(ps_index.entries[i + 1]);
+	}
+	return NULL;
+}
+
+//Reads the image of the given program into a new kernel heap block (to kfree()).
+//The image is read in requests of the max # sectors of the disk, merged by the disk queue.
+//Returns NULL if there's no memory or on disk error
+uint8* ps_read_image(struct ProgramStoreEntry* entry)
+{
+	uint32 nsecs = ROUNDUP(entry->size, SECTSIZE) / SECTSIZE;
+	uint32 maxSects = MIN(DQ_MAX_MERGE_SECTS, ide_max_sectors(0));
+	uint32 secno = PROGRAM_STORE_START_SECTOR + entry->sector;
+	uint32 done, n;
+	int ret = 0;
+
+	if (nsecs == 0 || entry->sector + nsecs > ps_index.header.nsectors)
+		return NULL;
+	uint8* image = kmalloc(nsecs * SECTSIZE);
+	if (image == NULL)
+		return NULL;
+
+	for (done = 0; done < nsecs && ret == 0; done += n)
+	{
+		n = MIN(maxSects, nsecs - done);
+		ret = dq_queue_read(0, secno + done, image + done * SECTSIZE, n);
+	}
+	if (ret == 0)
+		ret = dq_sync();
+	else
+		dq_sync();
+
+	if (ret != 0)
+	{
+		kfree(image);
+		return NULL;
+	}
+	return image;
+}
+
+void ps_print()
+{
+	int i;
+	if (ps_num_programs == 0)
+	{
+		cprintf("No program store on the disk\n");
+		return;
+	}
+	cprintf("Program store: %d programs, %d sectors at sector %d\n", ps_num_programs, ps_index.header.nsectors, PROGRAM_STORE_START_SECTOR);
+	for (i = 0; i < ps_num_programs; i++)
+	{
+		struct ProgramStoreEntry* entry = &(ps_index.entries[i + 1]);
+		cprintf("	%s: %d bytes at sector %d\n", entry->name, entry->size, entry->sector);
+	}
+}
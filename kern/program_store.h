@@ -0,0 +1,53 @@
+/* See COPYRIGHT for copyright information. */
+
+#ifndef FOS_KERN_PROGRAM_STORE_H
+#define FOS_KERN_PROGRAM_STORE_H
+#ifndef FOS_KERNEL
+# error "This is a FOS kernel header; user programs should not #include it"
+#endif
+
+#include <inc/types.h>
+#include <inc/disk.h>
+
+//2026: disk-resident program store
+//==================================
+//The ELF images of the user programs are packed by tools/mkprogstore into a store written on the
+//disk image at PROGRAM_STORE_START_SECTOR (after the kernel, before the page file):
+//	- an index of PS_INDEX_SECTORS sectors: a ProgramStoreHeader then one ProgramStoreEntry per program
+//	- the image of each program, starting on a sector boundary
+//get_user_program_info() looks up the programs missing from userPrograms[] in the index, and with
+//"make PROGSTORE=1" the programs aren't linked in the kernel at all: every program is read from the store.
+//The image of a program is read (in multi-sector requests) when its first env is created, and kept
+//in memory until its last env is freed (see env_program_image_attach()).
+
+#define PROGRAM_STORE_START_SECTOR	((10<<20) / SECTSIZE)	//should match PROGSTORE_START_SECTOR in kern/Makefrag
+//(the build checks that the store ends before PF_HEADER_SECTOR, PROGSTORE_END_SECTOR in kern/Makefrag)
+#define PS_INDEX_SECTORS			16
+#define PS_MAGIC					0x53475046		//"FPGS"
+#define PS_NAME_LEN					56
+
+struct ProgramStoreEntry
+{
+	char name[PS_NAME_LEN];		//name of the program (its ".c" filename)
+	uint32 sector;				//first sector of its image (from the start of the store)
+	uint32 size;				//size of its image in bytes
+};
+
+struct ProgramStoreHeader
+{
+	uint32 magic;
+	uint32 count;				//# programs
+	uint32 nsectors;			//size of the store (index included)
+	uint8 reserved[sizeof(struct ProgramStoreEntry) - 3 * sizeof(uint32)];
+};
+
+#define PS_MAX_PROGRAMS		(PS_INDEX_SECTORS * SECTSIZE / sizeof(struct ProgramStoreEntry) - 1)
+
+void ps_init();
+uint32 ps_count();
+struct ProgramStoreEntry* ps_get(uint32 index);
+struct ProgramStoreEntry* ps_find(const char* name);
+uint8* ps_read_image(struct ProgramStoreEntry* entry);
+void ps_print();
+
+#endif /* !FOS_KERN_PROGRAM_STORE_H */
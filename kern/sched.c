@@ -7,6 +7,9 @@
 #include <kern/trap.h>
 #include <kern/kheap.h>
 #include <kern/utilities.h>
+#include <kern/file_manager.h>
+#include <kern/pgtrace.h>
+#include <kern/disk_queue.h>
 
 //void on_clock_update_WS_time_stamps();
 extern uint32 isBufferingEnabled();
@@ -17,8 +20,10 @@ extern inline void pd_clear_page_dir_entry(struct Env *e, uint32 virtual_address
 //================
 
 void sched_delete_ready_queues() ;
+extern uint32 mlfq_ms_since_boost;
 uint32 isSchedMethodRR(){if(scheduler_method == SCH_RR) return 1; return 0;}
 uint32 isSchedMethodMLFQ(){if(scheduler_method == SCH_MLFQ) return 1; return 0;}
+uint32 isSchedMethodCFS(){if(scheduler_method == SCH_CFS) return 1; return 0;}
 
 //==================================================================================//
 //============================== HELPER FUNCTIONS ==================================//
@@ -69,6 +74,256 @@ void remove_from_queue(struct Env_Queue* queue, struct Env* e)
 	}
 }
 
+//2026: deadline envs (see sched_set_deadline())
+static void edf_insert(struct Env* env);
+static void edf_remove(struct Env* env);
+static struct Env* edf_pick();
+static void edf_requeue(struct Env* env);
+static void edf_throttle(struct Env* env, uint64 now);
+
+//2026: CFS tree (AVL, ordered by vruntime then env ID)
+static inline int cfs_before(struct Env* a, struct Env* b)
+{
+	return a->vruntime < b->vruntime || (a->vruntime == b->vruntime && a->env_id < b->env_id);
+}
+
+static inline int cfs_height(struct Env* node)
+{
+	return (node == NULL) ? 0 : node->cfsHeight;
+}
+
+static struct Env* cfs_rotate_right(struct Env* node)
+{
+	struct Env* left = node->cfsLeft;
+	node->cfsLeft = left->cfsRight;
+	left->cfsRight = node;
+	node->cfsHeight = 1 + MAX(cfs_height(node->cfsLeft), cfs_height(node->cfsRight));
+	left->cfsHeight = 1 + MAX(cfs_height(left->cfsLeft), cfs_height(left->cfsRight));
+	return left;
+}
+
+static struct Env* cfs_rotate_left(struct Env* node)
+{
+	struct Env* right = node->cfsRight;
+	node->cfsRight = right->cfsLeft;
+	right->cfsLeft = node;
+	node->cfsHeight = 1 + MAX(cfs_height(node->cfsLeft), cfs_height(node->cfsRight));
+	right->cfsHeight = 1 + MAX(cfs_height(right->cfsLeft), cfs_height(right->cfsRight));
+	return right;
+}
+
+static struct Env* cfs_balance(struct Env* node)
+{
+	node->cfsHeight = 1 + MAX(cfs_height(node->cfsLeft), cfs_height(node->cfsRight));
+	int balance = cfs_height(node->cfsLeft) - cfs_height(node->cfsRight);
+	if (balance > 1)
+	{
+		if (cfs_height(node->cfsLeft->cfsLeft) < cfs_height(node->cfsLeft->cfsRight))
+			node->cfsLeft = cfs_rotate_left(node->cfsLeft);
+		return cfs_rotate_right(node);
+	}
+	if (balance < -1)
+	{
+		if (cfs_height(node->cfsRight->cfsRight) < cfs_height(node->cfsRight->cfsLeft))
+			node->cfsRight = cfs_rotate_right(node->cfsRight);
+		return cfs_rotate_left(node);
+	}
+	return node;
+}
+
+static struct Env* cfs_tree_insert(struct Env* root, struct Env* env)
+{
+	if (root == NULL)
+	{
+		env->cfsLeft = env->cfsRight = NULL;
+		env->cfsHeight = 1;
+		return env;
+	}
+	if (cfs_before(env, root))
+		root->cfsLeft = cfs_tree_insert(root->cfsLeft, env);
+	else
+		root->cfsRight = cfs_tree_insert(root->cfsRight, env);
+	return cfs_balance(root);
+}
+
+static struct Env* cfs_tree_remove_min(struct Env* root, struct Env** min)
+{
+	if (root->cfsLeft == NULL)
+	{
+		*min = root;
+		return root->cfsRight;
+	}
+	root->cfsLeft = cfs_tree_remove_min(root->cfsLeft, min);
+	return cfs_balance(root);
+}
+
+static struct Env* cfs_tree_remove(struct Env* root, struct Env* env)
+{
+	if (root == NULL)
+		return NULL;
+	if (root == env)
+	{
+		struct Env* min;
+		if (root->cfsRight == NULL)
+			return root->cfsLeft;
+		struct Env* right = cfs_tree_remove_min(root->cfsRight, &min);
+		min->cfsLeft = root->cfsLeft;
+		min->cfsRight = right;
+		return cfs_balance(min);
+	}
+	if (cfs_before(env, root))
+		root->cfsLeft = cfs_tree_remove(root->cfsLeft, env);
+	else
+		root->cfsRight = cfs_tree_remove(root->cfsRight, env);
+	return cfs_balance(root);
+}
+
+//2026: weight of an env (from its priority) in the CFS and of its quantum in the RR, 1024 for the normal one
+uint32 cfs_weight(struct Env* env)
+{
+	static uint32 weights[PRIORITY_HIGH + 1] = {CFS_NICE_0_WEIGHT, 335, 655, 1024, 1586, 3121};
+	if (env->priority < PRIORITY_LOW || env->priority > PRIORITY_HIGH)
+		return CFS_NICE_0_WEIGHT;
+	return weights[env->priority];
+}
+
+//2026: insert/remove an env in the ready queue of the given level (keeping sched_ready_levels updated)
+//(and in the CFS tree with the CFS)
+void ready_queue_insert(int level, struct Env* env)
+{
+	enqueue(&(env_ready_queues[level]), env);
+	env->schedQueue = SCHQ_READY;
+	env->schedLevel = level;
+	sched_ready_levels |= (1 << level);
+	if (isSchedMethodCFS())
+	{
+		cfs_root = cfs_tree_insert(cfs_root, env);
+		cfs_total_weight += cfs_weight(env);
+	}
+}
+
+void ready_queue_remove(int level, struct Env* env)
+{
+	LIST_REMOVE(&(env_ready_queues[level]), env);
+	env->schedQueue = SCHQ_NONE;
+	if (LIST_EMPTY(&(env_ready_queues[level])))
+		sched_ready_levels &= ~(1 << level);
+	if (isSchedMethodCFS())
+	{
+		cfs_root = cfs_tree_remove(cfs_root, env);
+		cfs_total_weight -= cfs_weight(env);
+	}
+}
+
+//2026: dequeue the next env of the highest non-empty level (if any) and set the quantum of its level
+//(with the CFS: the leftmost env of the tree, for its share of the target latency)
+struct Env* ready_queue_pick()
+{
+	if (sched_ready_levels == 0)
+		return NULL;
+	//2026: the deadline envs first
+	if (sched_ready_levels & SCHED_EDF_READY)
+	{
+		return edf_pick();
+	}
+	if (isSchedMethodCFS())
+	{
+		struct Env* env = cfs_root;
+		while (env->cfsLeft != NULL)
+			env = env->cfsLeft;
+		ready_queue_remove(0, env);
+		cfs_min_vruntime = MAX(cfs_min_vruntime, env->vruntime);
+
+		uint32 weight = cfs_weight(env);
+		uint32 slice = (uint64)cfs_latency_ms * 1000 * weight / (cfs_total_weight + weight);
+		kclock_set_quantum_us(MAX(slice, CFS_MIN_GRANULARITY_US));
+		return env;
+	}
+	int level = __builtin_ctz(sched_ready_levels);
+	struct Env* env = LIST_LAST(&(env_ready_queues[level]));
+	ready_queue_remove(level, env);
+	kclock_set_quantum_us(sched_quantum_us(env, level));
+	return env;
+}
+
+//2026: quantum (in us) of the given env at the given level: with the RR, the quantum is scaled
+//by its weight (see cfs_weight())
+uint32 sched_quantum_us(struct Env* env, int level)
+{
+	if (!isSchedMethodRR())
+		return quantums[level] * 1000;
+	return MIN(quantums[level] * 1000 * cfs_weight(env) / CFS_NICE_0_WEIGHT, kclock_max_interval_ms() * 1000);
+}
+
+//2026: initial MLFQ level of the given env: level 0 from the normal priority up, then the lower
+//its priority, the lower its level (the lowest one for PRIORITY_LOW)
+uint8 sched_priority_level(struct Env* env)
+{
+	if (env->priority >= PRIORITY_NORMAL || num_of_ready_queues <= 1)
+		return 0;
+	return (PRIORITY_NORMAL - env->priority) * (num_of_ready_queues - 1) / (PRIORITY_NORMAL - PRIORITY_LOW);
+}
+
+//2026: set the priority of the given env, with its initial MLFQ level. If it's ready, it's
+//moved to its new level (and its new weight is accounted in the CFS tree)
+void sched_set_priority(struct Env* env, int priority)
+{
+	uint8 isReady = (env->env_status == ENV_READY && env->dlPeriod == 0);
+	if (isReady)
+		ready_queue_remove(env->schedLevel, env);
+	env->priority = priority;
+	env->schedLevel = sched_priority_level(env);
+	if (isReady)
+		ready_queue_insert(env->schedLevel, env);
+}
+
+//2026: the env of the given ID, by its index in envs[] (the ID is validated as in envid2env()),
+//NULL if it doesn't exist (anymore)
+struct Env* sched_find_env(uint32 envId)
+{
+	struct Env* env;
+	if (envId == 0 || envid2env(envId, &env, 0) < 0)
+		return NULL;
+	return env;
+}
+
+char* sched_queue_names[] = {"", "NEW", "READY", "DEADLINE", "BLOCKED", "SLEEPING", "SUSPENDED", "EXIT", "WAITING"};
+
+//2026: remove the given env from the queue it's in (if any)
+void sched_remove_from_queue(struct Env* env)
+{
+	switch (env->schedQueue)
+	{
+	case SCHQ_NEW:
+		LIST_REMOVE(&env_new_queue, env);
+		break;
+	case SCHQ_READY:
+		ready_queue_remove(env->schedLevel, env);
+		break;
+	case SCHQ_DEADLINE:
+		edf_remove(env);
+		break;
+	case SCHQ_BLOCKED:
+		//(its page-in is dropped)
+		LIST_REMOVE(&env_blocked_queue, env);
+		pf_async_cancel(env);
+		break;
+	case SCHQ_SLEEPING:
+		sched_remove_sleeping_env(env);
+		break;
+	case SCHQ_SUSPENDED:
+		LIST_REMOVE(&env_suspended_queue, env);
+		break;
+	case SCHQ_EXIT:
+		LIST_REMOVE(&env_exit_queue, env);
+		break;
+	case SCHQ_WAITING:
+		LIST_REMOVE(&env_waiting_queue, env);
+		break;
+	}
+	env->schedQueue = SCHQ_NONE;
+}
+
 struct Env* find_env_in_queue(struct Env_Queue* queue, uint32 envID)
 {
 	struct Env * ptr_env=NULL;
@@ -105,7 +360,10 @@ void sched_init_MLFQ(uint8 numOfLevels, uint8 *quantumOfEachLevel)
 	//[1] Create the ready queues and initialize them using init_queue()
 	//[2] Create the "quantums" array and initialize it by the given quantums in "quantumOfEachLevel[]"
 	//[3] Set the CPU quantum by the first level one
+	numOfLevels = MIN(numOfLevels, MLFQ_MAX_LEVELS);
 	num_of_ready_queues=numOfLevels;
+	sched_ready_levels &= SCHED_EDF_READY;
+	mlfq_ms_since_boost = 0;
     env_ready_queues=kmalloc(num_of_ready_queues* sizeof(struct Env_Queue));
     quantums=kmalloc(numOfLevels* sizeof(uint8));
 	uint8 quantum_in_ms=quantumOfEachLevel[0];
@@ -124,41 +382,51 @@ void sched_init_MLFQ(uint8 numOfLevels, uint8 *quantumOfEachLevel)
 }
 
 
-int current_env_level;
 struct Env* fos_scheduler_MLFQ()
 {
 	//Steps:
 	//======
-	//[1] If the current environment (curenv) exists, place it in the suitable queue
-       if(curenv!=NULL)
-    {//need to get its level
-    	   if(current_env_level == num_of_ready_queues-1)
-    	   	   {
-    	   		   enqueue(&env_ready_queues[current_env_level],curenv);
-
-    	   	   }
-    	   else
-    		   enqueue(&env_ready_queues[current_env_level+1],curenv);
-	       }
-
-	//[2] Search for the next env in the queues according to their priorities (first is highest)
-       struct Env*nextenv;
-       for(int i=0;i<num_of_ready_queues;i++)
-       {
-    	   if(queue_size(&env_ready_queues[i])!= 0)
-    	   {
-    		    current_env_level=i;
-    		    nextenv=dequeue(&env_ready_queues[i]);
-    			kclock_set_quantum(quantums[i]);
-    		    return nextenv;
-                //uint8 quantum_in_ms=current_env_level[i];
-    			//kclock_set_quantum(quantum_in_ms);
-    	   }
+	//[1] If the current environment (curenv) exists, place it in the queue of its level
+	//	  (one level down if it has used its full quantum, so an env giving up the CPU early keeps its level)
+	if (curenv != NULL)
+	{
+		if (sched_quantum_expired && curenv->schedLevel < num_of_ready_queues - 1)
+			curenv->schedLevel++;
+		sched_insert_ready(curenv);
+	}
 
+	//[2] Pick the next env from the highest non-empty level
+	return ready_queue_pick();
+}
 
-       }
+//2026: move all the envs to level 0 (so the ones at the low levels don't starve)
+void sched_boost_MLFQ()
+{
+	struct Env* ptr_env;
+	for (int i = 1 ; i < num_of_ready_queues ; i++)
+	{
+		while ((ptr_env = dequeue(&(env_ready_queues[i]))) != NULL)
+		{
+			ptr_env->schedLevel = 0;
+			ready_queue_insert(0, ptr_env);
+		}
+	}
+	sched_ready_levels &= (1 | SCHED_EDF_READY);
 
-           		   return NULL;
+	LIST_FOREACH(ptr_env, &env_blocked_queue)
+		ptr_env->schedLevel = 0;
+	LIST_FOREACH(ptr_env, &env_suspended_queue)
+		ptr_env->schedLevel = 0;
+	for (int i = 0 ; i < TW_NUM_SLOTS && sched_num_sleeping > 0 ; i++)
+	{
+		LIST_FOREACH(ptr_env, &(sched_timer_wheel[i]))
+			ptr_env->schedLevel = 0;
+	}
+	if (curenv != NULL)
+	{
+		curenv->schedLevel = 0;
+		sched_quantum_expired = 0;
+	}
 }
 
 
@@ -172,11 +440,24 @@ void fos_scheduler(void)
 {
 
 	chk1();
+	//2026: the quantum is replaced before its end (the curenv yields, sleeps, blocks, exits...):
+	//the part already used advances the clock of the timer wheel (at its end, the clock handler did it)
+	if (scheduler_status == SCH_STARTED && !sched_quantum_expired)
+	{
+		sched_advance_time_us(kclock_elapsed_us());
+	}
 	scheduler_status = SCH_STARTED;
 
 	//This variable should be set to the next environment to be run (if any)
 	struct Env* next_env = NULL;
 
+	//2026: a deadline env is requeued (or throttled) by the EDF, whatever the method is
+	if (curenv != NULL && curenv->dlPeriod != 0)
+	{
+		edf_requeue(curenv);
+		curenv = NULL;
+	}
+
 	if (scheduler_method == SCH_RR)
 	{
 		// Implement simple round-robin scheduling.
@@ -188,21 +469,31 @@ void fos_scheduler(void)
 		//If the curenv is still exist, then insert it again in the ready queue
 		if (curenv != NULL)
 		{
-			enqueue(&(env_ready_queues[0]), curenv);
+			sched_insert_ready(curenv);
 		}
 
 		//Pick the next environment from the ready queue
-		next_env = dequeue(&(env_ready_queues[0]));
-
-		//Reset the quantum
-		//Reset the value of CNT0 for the next clock interval
-		kclock_set_quantum(quantums[0]);
+		//(2026: it sets the quantum)
+		next_env = ready_queue_pick();
 
 	}
 	else if (scheduler_method == SCH_MLFQ)
 	{
 		next_env = fos_scheduler_MLFQ();
 	}
+	//2026
+	else if (scheduler_method == SCH_CFS)
+	{
+		//the curenv goes back to the tree with its updated vruntime (see sched_account_trap())
+		if (curenv != NULL)
+		{
+			curenv->env_status = ENV_READY;
+			curenv->lastTimestamp = kclock_now_ns();
+			ready_queue_insert(0, curenv);
+		}
+		next_env = ready_queue_pick();
+	}
+	sched_quantum_expired = 0;
 
 
 	//temporarily set the curenv by the next env JUST for checking the scheduler
@@ -212,9 +503,37 @@ void fos_scheduler(void)
 	chk2(next_env);
 	curenv = old_curenv;
 
+	//2026: all the envs are waiting for their page-in or their wake-up time => wait for them
+	if (next_env == NULL && (!LIST_EMPTY(&env_blocked_queue) || sched_num_sleeping > 0))
+	{
+		while (sched_ready_levels == 0 && (!LIST_EMPTY(&env_blocked_queue) || sched_num_sleeping > 0))
+		{
+			sched_idle_wait();
+			if (!LIST_EMPTY(&env_blocked_queue))
+			{
+				pf_async_complete(0);
+			}
+		}
+		next_env = ready_queue_pick();
+	}
+
+	//2026: nothing is ready, so there's no more memory pressure => bring back a suspended env (if any)
+	if (next_env == NULL && !LIST_EMPTY(&env_suspended_queue))
+	{
+		next_env = sched_resume_env();
+		next_env->schedLevel = 0;
+		kclock_set_quantum(quantums[0]);
+	}
+
 	//cprintf("Scheduler select program '%s'\n", next_env->prog_name);
 	if(next_env != NULL)
 	{
+		//2026: dynamic ticks: nothing else is ready => no preemption, the clock only keeps the time
+		sched_long_tick = (sched_ready_levels == 0 && next_env->dlPeriod == 0);
+		if (sched_long_tick)
+		{
+			kclock_set_quantum(sched_time_to_next_wakeup());
+		}
 		env_run(next_env);
 	}
 	else
@@ -223,6 +542,9 @@ void fos_scheduler(void)
 		//lcr3(K_PHYSICAL_ADDRESS(ptr_page_directory));
 		lcr3(phys_page_directory);
 
+		//2026: no more envs => nothing should stay in the disk queue
+		dq_flush();
+
 		//cprintf("SP = %x\n", read_esp());
 
 		scheduler_status = SCH_STOPPED;
@@ -241,6 +563,7 @@ void sched_init_RR(uint8 quantum)
 
 	// Create 1 ready queue for the RR
 	num_of_ready_queues = 1;
+	sched_ready_levels &= SCHED_EDF_READY;
 	env_ready_queues = kmalloc(sizeof(struct Env_Queue));
 	quantums = kmalloc(num_of_ready_queues * sizeof(uint8)) ;
 	quantums[0] = quantum;
@@ -250,6 +573,27 @@ void sched_init_RR(uint8 quantum)
 
 
 
+//2026
+void sched_init_CFS(uint8 latency)
+{
+	sched_delete_ready_queues();
+	scheduler_status = SCH_STOPPED;
+	scheduler_method = SCH_CFS;
+
+	// 1 ready queue (to list the ready envs), ordered by the CFS tree
+	num_of_ready_queues = 1;
+	sched_ready_levels &= SCHED_EDF_READY;
+	env_ready_queues = kmalloc(sizeof(struct Env_Queue));
+	quantums = kmalloc(num_of_ready_queues * sizeof(uint8)) ;
+	quantums[0] = latency;
+	kclock_set_quantum(quantums[0]);
+	init_queue(&(env_ready_queues[0]));
+
+	cfs_root = NULL;
+	cfs_total_weight = 0;
+	cfs_latency_ms = latency;
+}
+
 void sched_init()
 {
 	old_pf_counter = 0;
@@ -258,6 +602,19 @@ void sched_init()
 
 	init_queue(&env_new_queue);
 	init_queue(&env_exit_queue);
+	init_queue(&env_suspended_queue);
+	init_queue(&env_blocked_queue);
+	init_queue(&env_deadline_queue);
+	init_queue(&env_waiting_queue);
+	edf_total_utilization = 0;
+	for (int i = 0 ; i < TW_NUM_SLOTS ; i++)
+	{
+		init_queue(&(sched_timer_wheel[i]));
+	}
+	sched_time_ms = 0;
+	sched_num_sleeping = 0;
+
+	sched_init_load_control(LC_OFF, LC_DEFAULT_FAULTS_PER_TICK, LC_DEFAULT_LOW_FREE_FRAMES);
 }
 
 void sched_delete_ready_queues()
@@ -271,26 +628,34 @@ void sched_insert_ready(struct Env* env)
 {
 	if(env != NULL)
 	{
+		//2026: a deadline env goes to the EDF queue
+		if (env->dlPeriod != 0)
+		{
+			env->env_status = ENV_READY ;
+			env->lastTimestamp = kclock_now_ns();
+			edf_insert(env);
+			return;
+		}
+		//2026: CFS: placement of an env made ready (new, woken up)
+		uint64 minVruntime = cfs_min_vruntime - MIN(cfs_min_vruntime, cfs_latency_ms * 1000000ULL / 2);
+		env->vruntime = MAX(env->vruntime, minVruntime);
+
 		env->env_status = ENV_READY ;
-		enqueue(&(env_ready_queues[0]), env);
+		env->lastTimestamp = kclock_now_ns();
+		//2026: (in its MLFQ level)
+		env->schedLevel = MIN(env->schedLevel, num_of_ready_queues - 1);
+		ready_queue_insert(env->schedLevel, env);
 	}
 }
 
 
 void sched_remove_ready(struct Env* env)
 {
-	if(env != NULL)
+	//2026: (O(1): the env knows its queue)
+	if(env != NULL && (env->schedQueue == SCHQ_READY || env->schedQueue == SCHQ_DEADLINE))
 	{
-		for (int i = 0 ; i < num_of_ready_queues ; i++)
-		{
-			struct Env * ptr_env = find_env_in_queue(&(env_ready_queues[i]), env->env_id);
-			if (ptr_env != NULL)
-			{
-				LIST_REMOVE(&(env_ready_queues[i]), env);
-				env->env_status = ENV_UNKNOWN;
-				return;
-			}
-		}
+		sched_remove_from_queue(env);
+		env->env_status = ENV_UNKNOWN;
 	}
 }
 
@@ -299,7 +664,10 @@ void sched_insert_new(struct Env* env)
 	if(env != NULL)
 	{
 		env->env_status = ENV_NEW ;
+		env->schedLevel = sched_priority_level(env);
+		env->vruntime = cfs_min_vruntime;
 		enqueue(&env_new_queue, env);
+		env->schedQueue = SCHQ_NEW;
 	}
 }
 void sched_remove_new(struct Env* env)
@@ -307,6 +675,7 @@ void sched_remove_new(struct Env* env)
 	if(env != NULL)
 	{
 		LIST_REMOVE(&env_new_queue, env) ;
+		env->schedQueue = SCHQ_NONE;
 		env->env_status = ENV_UNKNOWN;
 	}
 }
@@ -316,8 +685,12 @@ void sched_insert_exit(struct Env* env)
 	if(env != NULL)
 	{
 		if(isBufferingEnabled()) {cleanup_buffers(env);}
+		sched_clear_deadline(env);
 		env->env_status = ENV_EXIT ;
 		enqueue(&env_exit_queue, env);
+		env->schedQueue = SCHQ_EXIT;
+		//2026
+		sched_wake_parent(env);
 	}
 }
 void sched_remove_exit(struct Env* env)
@@ -325,6 +698,7 @@ void sched_remove_exit(struct Env* env)
 	if(env != NULL)
 	{
 		LIST_REMOVE(&env_exit_queue, env) ;
+		env->schedQueue = SCHQ_NONE;
 		env->env_status = ENV_UNKNOWN;
 	}
 }
@@ -345,6 +719,24 @@ void sched_print_all()
 		cprintf("\nNo processes in NEW queue\n");
 	}
 	cprintf("================================================\n");
+	if (!LIST_EMPTY(&env_waiting_queue))
+	{
+		cprintf("The processes WAITING for a child are:\n");
+		LIST_FOREACH(ptr_env, &env_waiting_queue)
+		{
+			cprintf("	[%d] %s (for %d)\n", ptr_env->env_id, ptr_env->prog_name, ptr_env->waitEnvId);
+		}
+		cprintf("================================================\n");
+	}
+	if (!LIST_EMPTY(&env_deadline_queue))
+	{
+		cprintf("The processes in the DEADLINE queue are:\n");
+		LIST_FOREACH(ptr_env, &env_deadline_queue)
+		{
+			cprintf("	[%d] %s (%d ms every %d ms)\n", ptr_env->env_id, ptr_env->prog_name, ptr_env->dlRuntime, ptr_env->dlPeriod);
+		}
+		cprintf("================================================\n");
+	}
 	for (int i = 0 ; i < num_of_ready_queues ; i++)
 	{
 		if (!LIST_EMPTY(&(env_ready_queues[i])))
@@ -361,6 +753,37 @@ void sched_print_all()
 		}
 		cprintf("================================================\n");
 	}
+	if (!LIST_EMPTY(&env_blocked_queue))
+	{
+		cprintf("The processes in BLOCKED queue are:\n");
+		LIST_FOREACH(ptr_env, &env_blocked_queue)
+		{
+			cprintf("	[%d] %s (page-in of %x)\n", ptr_env->env_id, ptr_env->prog_name, ptr_env->pendingPageInVA);
+		}
+		cprintf("================================================\n");
+	}
+	if (sched_num_sleeping > 0)
+	{
+		cprintf("The processes SLEEPING are:\n");
+		for (int i = 0 ; i < TW_NUM_SLOTS ; i++)
+		{
+			LIST_FOREACH(ptr_env, &(sched_timer_wheel[i]))
+			{
+				cprintf("	[%d] %s (wake up in %d ms)%s\n", ptr_env->env_id, ptr_env->prog_name, ptr_env->wakeupTime - sched_time_ms,
+						ptr_env->dlThrottled ? " throttled" : "");
+			}
+		}
+		cprintf("================================================\n");
+	}
+	if (!LIST_EMPTY(&env_suspended_queue))
+	{
+		cprintf("The processes in SUSPENDED queue are:\n");
+		LIST_FOREACH(ptr_env, &env_suspended_queue)
+		{
+			cprintf("	[%d] %s\n", ptr_env->env_id, ptr_env->prog_name);
+		}
+		cprintf("================================================\n");
+	}
 	if (!LIST_EMPTY(&env_exit_queue))
 	{
 		cprintf("The processes in EXIT queue are:\n");
@@ -407,6 +830,31 @@ void sched_kill_all()
 		cprintf("No processes in NEW queue\n");
 	}
 	cprintf("================================================\n");
+	//2026: (before their children, whose killing would wake them up)
+	if (!LIST_EMPTY(&env_waiting_queue))
+	{
+		cprintf("KILLING the processes WAITING for a child...\n");
+		LIST_FOREACH(ptr_env, &env_waiting_queue)
+		{
+			cprintf("	killing[%d] %s...", ptr_env->env_id, ptr_env->prog_name);
+			LIST_REMOVE(&env_waiting_queue, ptr_env);
+			start_env_free(ptr_env);
+			cprintf("DONE\n");
+		}
+		cprintf("================================================\n");
+	}
+	if (!LIST_EMPTY(&env_deadline_queue))
+	{
+		cprintf("KILLING the processes in the DEADLINE queue...\n");
+		LIST_FOREACH(ptr_env, &env_deadline_queue)
+		{
+			cprintf("	killing[%d] %s...", ptr_env->env_id, ptr_env->prog_name);
+			edf_remove(ptr_env);
+			start_env_free(ptr_env);
+			cprintf("DONE\n");
+		}
+		cprintf("================================================\n");
+	}
 	for (int i = 0 ; i < num_of_ready_queues ; i++)
 	{
 		if (!LIST_EMPTY(&(env_ready_queues[i])))
@@ -415,7 +863,7 @@ void sched_kill_all()
 			LIST_FOREACH(ptr_env, &(env_ready_queues[i]))
 			{
 				cprintf("	killing[%d] %s...", ptr_env->env_id, ptr_env->prog_name);
-				LIST_REMOVE(&(env_ready_queues[i]), ptr_env);
+				ready_queue_remove(i, ptr_env);
 				start_env_free(ptr_env);
 				cprintf("DONE\n");
 			}
@@ -427,6 +875,48 @@ void sched_kill_all()
 		cprintf("================================================\n");
 	}
 
+	if (!LIST_EMPTY(&env_blocked_queue))
+	{
+		cprintf("KILLING the processes in the BLOCKED queue...\n");
+		LIST_FOREACH(ptr_env, &env_blocked_queue)
+		{
+			cprintf("	killing[%d] %s...", ptr_env->env_id, ptr_env->prog_name);
+			LIST_REMOVE(&env_blocked_queue, ptr_env);
+			start_env_free(ptr_env);
+			cprintf("DONE\n");
+		}
+		cprintf("================================================\n");
+	}
+
+	if (sched_num_sleeping > 0)
+	{
+		cprintf("KILLING the SLEEPING processes...\n");
+		for (int i = 0 ; i < TW_NUM_SLOTS ; i++)
+		{
+			LIST_FOREACH(ptr_env, &(sched_timer_wheel[i]))
+			{
+				cprintf("	killing[%d] %s...", ptr_env->env_id, ptr_env->prog_name);
+				sched_remove_sleeping_env(ptr_env);
+				start_env_free(ptr_env);
+				cprintf("DONE\n");
+			}
+		}
+		cprintf("================================================\n");
+	}
+
+	if (!LIST_EMPTY(&env_suspended_queue))
+	{
+		cprintf("KILLING the processes in the SUSPENDED queue...\n");
+		LIST_FOREACH(ptr_env, &env_suspended_queue)
+		{
+			cprintf("	killing[%d] %s...", ptr_env->env_id, ptr_env->prog_name);
+			LIST_REMOVE(&env_suspended_queue, ptr_env);
+			start_env_free(ptr_env);
+			cprintf("DONE\n");
+		}
+		cprintf("================================================\n");
+	}
+
 	if (!LIST_EMPTY(&env_exit_queue))
 	{
 		cprintf("KILLING the processes in the EXIT queue...\n");
@@ -460,194 +950,168 @@ void sched_new_env(struct Env* e)
 
 void sched_run_env(uint32 envId)
 {
-	struct Env* ptr_env=NULL;
-	LIST_FOREACH(ptr_env, &env_new_queue)
+	//2026: (O(1) lookup, see sched_find_env())
+	struct Env* ptr_env = sched_find_env(envId);
+	if (ptr_env != NULL && ptr_env->schedQueue == SCHQ_NEW)
 	{
-		if(ptr_env->env_id == envId)
-		{
-			sched_remove_new(ptr_env);
-			sched_insert_ready(ptr_env);
+		sched_remove_new(ptr_env);
+		sched_insert_ready(ptr_env);
 
-			/*2015*///if scheduler not run yet, then invoke it!
-			if (scheduler_status == SCH_STOPPED)
-			{
-				fos_scheduler();
-			}
-			break;
+		/*2015*///if scheduler not run yet, then invoke it!
+		if (scheduler_status == SCH_STOPPED)
+		{
+			fos_scheduler();
 		}
 	}
-
 }
 
 void sched_exit_env(uint32 envId)
 {
-	struct Env* ptr_env=NULL;
-	int found = 0;
-	if (!found)
+	//2026: (O(1) lookup & removal from its queue)
+	struct Env* ptr_env = sched_find_env(envId);
+	if (ptr_env == NULL || ptr_env->schedQueue == SCHQ_EXIT)
+		return;
+	if (ptr_env->schedQueue == SCHQ_NONE && ptr_env != curenv)
+		return;
+
+	sched_remove_from_queue(ptr_env);
+	sched_insert_exit(ptr_env);
+
+	//If it's the curenv, then reinvoke the scheduler as there's no meaning to return back to an exited env
+	if (ptr_env == curenv)
 	{
-		LIST_FOREACH(ptr_env, &env_new_queue)
-				{
-			if(ptr_env->env_id == envId)
-			{
-				sched_remove_new(ptr_env);
-				found = 1;
-				//			return;
-			}
-				}
+		curenv = NULL;
+		fos_scheduler();
 	}
-	if (!found)
+}
+
+void sched_exit_all_ready_envs()
+{
+	struct Env* ptr_env=NULL;
+	//2026: the queues are drained rather than iterated: sched_insert_exit() may wake up a waiting
+	//parent, inserting it in one of them (LIST_FOREACH there would overwrite the cursor of the loop)
+	do
 	{
+		while ((ptr_env = LIST_FIRST(&env_deadline_queue)) != NULL)
+		{
+			edf_remove(ptr_env);
+			sched_insert_exit(ptr_env);
+		}
 		for (int i = 0 ; i < num_of_ready_queues ; i++)
 		{
-			if (!LIST_EMPTY(&(env_ready_queues[i])))
+			while ((ptr_env = LIST_FIRST(&(env_ready_queues[i]))) != NULL)
 			{
-				ptr_env=NULL;
-				LIST_FOREACH(ptr_env, &(env_ready_queues[i]))
-				{
-					if(ptr_env->env_id == envId)
-					{
-						LIST_REMOVE(&(env_ready_queues[i]), ptr_env);
-						found = 1;
-						break;
-					}
-				}
+				ready_queue_remove(i, ptr_env);
+				sched_insert_exit(ptr_env);
 			}
-			if (found)
-				break;
 		}
-	}
-	if (!found)
+	} while (!LIST_EMPTY(&env_deadline_queue));
+}
+
+void sched_kill_env(uint32 envId)
+{
+	//2026: (O(1) lookup & removal from its queue)
+	struct Env* ptr_env = sched_find_env(envId);
+	if (ptr_env == NULL)
+		return;
+
+	if (ptr_env->schedQueue == SCHQ_READY)
+		cprintf("killing[%d] %s from the READY queue #%d...", ptr_env->env_id, ptr_env->prog_name, ptr_env->schedLevel);
+	else if (ptr_env->schedQueue == SCHQ_SLEEPING)
+		cprintf("killing[%d] %s while SLEEPING...", ptr_env->env_id, ptr_env->prog_name);
+	else if (ptr_env->schedQueue != SCHQ_NONE)
+		cprintf("killing[%d] %s from the %s queue...", ptr_env->env_id, ptr_env->prog_name, sched_queue_names[ptr_env->schedQueue]);
+	else if (ptr_env == curenv)
 	{
-		if (curenv->env_id == envId)
-		{
-			ptr_env = curenv;
-			found = 1;
-		}
+		assert(ptr_env->env_status == ENV_RUNNABLE);
+		cprintf("killing a RUNNABLE environment [%d] %s...", ptr_env->env_id, ptr_env->prog_name);
 	}
+	else
+		return;
 
-	if (found)
-	{
-		sched_insert_exit(ptr_env);
+	sched_remove_from_queue(ptr_env);
+	start_env_free(ptr_env);
+	cprintf("DONE\n");
 
-		//If it's the curenv, then reinvoke the scheduler as there's no meaning to return back to an exited env
-		if (curenv->env_id == envId)
-		{
-			curenv = NULL;
-			fos_scheduler();
-		}
+	//If it's the curenv, then reset it and reinvoke the scheduler
+	//as there's no meaning to return back to a killed env
+	if (ptr_env == curenv)
+	{
+		//lcr3(K_PHYSICAL_ADDRESS(ptr_page_directory));
+		lcr3(phys_page_directory);
+		curenv = NULL;
+		fos_scheduler();
 	}
 }
 
-void sched_exit_all_ready_envs()
+
+uint32 mlfq_ms_since_boost;
+void clock_interrupt_handler()
 {
-	struct Env* ptr_env=NULL;
-	for (int i = 0 ; i < num_of_ready_queues ; i++)
+	//cputchar('i');
+
+	//2026: the end of the idle time: just go back to sched_idle_wait()
+	//(with the local APIC, a pending interrupt of a quantum replaced meanwhile is ignored)
+	if (kclock_remaining_us() > 0)
 	{
-		if (!LIST_EMPTY(&(env_ready_queues[i])))
+		return;
+	}
+	if (sched_idling)
+	{
+		sched_idling = 0;
+		sched_advance_time_us(kclock_quantum_us);
+		return;
+	}
+
+	//2026: the curenv has used its full quantum
+	if (curenv != NULL)
+	{
+		sched_advance_time_us(kclock_quantum_us);
+		sched_quantum_expired = 1;
+		if (isSchedMethodMLFQ())
 		{
-			ptr_env=NULL;
-			LIST_FOREACH(ptr_env, &(env_ready_queues[i]))
+			mlfq_ms_since_boost += kclock_quantum_us / 1000;
+			if (mlfq_ms_since_boost >= MLFQ_BOOST_PERIOD_MS)
 			{
-				LIST_REMOVE(&(env_ready_queues[i]), ptr_env);
-				sched_insert_exit(ptr_env);
+				sched_boost_MLFQ();
+				mlfq_ms_since_boost = 0;
 			}
 		}
 	}
-}
 
-void sched_kill_env(uint32 envId)
-{
-	struct Env* ptr_env=NULL;
-	int found = 0;
-	if (!found)
+	if(isPageReplacmentAlgorithmLRU())
 	{
-		LIST_FOREACH(ptr_env, &env_new_queue)
-					{
-			if(ptr_env->env_id == envId)
-			{
-				cprintf("killing[%d] %s from the NEW queue...", ptr_env->env_id, ptr_env->prog_name);
-				sched_remove_new(ptr_env);
-				start_env_free(ptr_env);
-				cprintf("DONE\n");
-				found = 1;
-				//			return;
-			}
-					}
+		update_WS_time_stamps();
 	}
-	if (!found)
+	//2026: the page trace samples the USED pages at each tick (by update_WS_time_stamps() under LRU)
+	else if (isPgTraceEnabled() && curenv != NULL)
 	{
-		for (int i = 0 ; i < num_of_ready_queues ; i++)
-		{
-			if (!LIST_EMPTY(&(env_ready_queues[i])))
-			{
-				ptr_env=NULL;
-				LIST_FOREACH(ptr_env, &(env_ready_queues[i]))
-				{
-					if(ptr_env->env_id == envId)
-					{
-						cprintf("killing[%d] %s from the READY queue #%d...", ptr_env->env_id, ptr_env->prog_name, i);
-						LIST_REMOVE(&(env_ready_queues[i]), ptr_env);
-						start_env_free(ptr_env);
-						cprintf("DONE\n");
-						found = 1;
-						break;
-						//return;
-					}
-				}
-			}
-			if (found)
-				break;
-		}
+		pgtrace_sample_ws(curenv);
 	}
-	if (!found)
+	//2026: end of the recording window of the WS profile
+	if (curenv != NULL && curenv->ptr_profile != NULL && curenv->nClocks >= WS_PROFILE_RECORD_TICKS)
 	{
-		ptr_env=NULL;
-		LIST_FOREACH(ptr_env, &env_exit_queue)
-		{
-			if(ptr_env->env_id == envId)
-			{
-				cprintf("killing[%d] %s from the EXIT queue...", ptr_env->env_id, ptr_env->prog_name);
-				sched_remove_exit(ptr_env);
-				start_env_free(ptr_env);
-				cprintf("DONE\n");
-				found = 1;
-				//return;
-			}
-		}
+		env_ws_profile_save(curenv);
 	}
-
-	if (!found)
+	if (load_control_status == LC_ON)
 	{
-		if (curenv->env_id == envId)
-		{
-			ptr_env = curenv;
-			assert(ptr_env->env_id == ENV_RUNNABLE);
-			cprintf("killing a RUNNABLE environment [%d] %s...", ptr_env->env_id, ptr_env->prog_name);
-			start_env_free(ptr_env);
-			cprintf("DONE\n");
-			found = 1;
-		}
+		sched_check_load();
 	}
-	//If it's the curenv, then reset it and reinvoke the scheduler
-	//as there's no meaning to return back to a killed env
-	if (curenv->env_id == envId)
+	//2026: in case the IRQ14 of a completed page-in was missed
+	if (!LIST_EMPTY(&env_blocked_queue))
 	{
-		//lcr3(K_PHYSICAL_ADDRESS(ptr_page_directory));
-		lcr3(phys_page_directory);
-		curenv = NULL;
-		fos_scheduler();
+		pf_async_complete(0);
 	}
+	//2026: issue the write-backs queued since the last tick
+	if (dq_flush_background() != 0)
+		panic("Error writing on disk\n");
 
-}
-
-
-void clock_interrupt_handler()
-{
-	//cputchar('i');
-
-	if(isPageReplacmentAlgorithmLRU())
+	//2026: dynamic ticks: the curenv is still alone => keep running it on a new long tick
+	if (sched_long_tick && curenv != NULL && sched_ready_levels == 0)
 	{
-		update_WS_time_stamps();
+		sched_quantum_expired = 0;
+		kclock_set_quantum(sched_time_to_next_wakeup());
+		return;
 	}
 	//cprintf("Clock Handler\n") ;
 	fos_scheduler();
@@ -671,6 +1135,10 @@ void update_WS_time_stamps()
 
 					if (perm & PERM_USED)
 					{
+						if (isPgTraceEnabled())
+						{
+							pgtrace_record_sample(curr_env_ptr, page_va, perm);
+						}
 						curr_env_ptr->ptr_pageWorkingSet[i].time_stamp = (oldTimeStamp>>2) | 0x80000000;
 						pt_set_page_permissions(curr_env_ptr, page_va, 0 , PERM_USED) ;
 					}
@@ -708,3 +1176,558 @@ void update_WS_time_stamps()
 }
 
 
+//==================================================================================//
+//================================= LOAD CONTROL ===================================//
+//==================================================================================//
+
+uint32 lc_window_ticks ;
+
+void sched_init_load_control(uint8 onoff, uint32 faultsPerTick, uint32 lowFreeFrames)
+{
+	load_control_status = (onoff == 0) ? LC_OFF : LC_ON;
+	lc_faults_per_tick = faultsPerTick;
+	lc_low_free_frames = lowFreeFrames;
+	lc_window_faults = 0;
+	lc_window_ticks = 0;
+}
+
+//Number of envs competing for the memory (the running one + the ready ones, deadline envs included)
+int sched_count_active_envs()
+{
+	int count = (curenv != NULL) ? 1 : 0;
+	for (int i = 0 ; i < num_of_ready_queues ; i++)
+	{
+		count += queue_size(&(env_ready_queues[i]));
+	}
+	count += queue_size(&env_deadline_queue);
+	return count;
+}
+
+//Victim = the lowest priority env, and among equal priorities, the one with the largest resident set
+//(2026: never a deadline env: it would miss its deadline. NULL if there's no other env)
+struct Env* sched_select_suspension_victim()
+{
+	struct Env* victim = (curenv != NULL && curenv->dlPeriod == 0) ? curenv : NULL;
+	uint32 victimSize = (victim != NULL) ? env_page_ws_get_size(victim) : 0;
+	struct Env* ptr_env = NULL;
+	for (int i = 0 ; i < num_of_ready_queues ; i++)
+	{
+		LIST_FOREACH(ptr_env, &(env_ready_queues[i]))
+		{
+			if (ptr_env->dlPeriod != 0)
+				continue;
+			uint32 size = env_page_ws_get_size(ptr_env);
+			if (victim == NULL || ptr_env->priority < victim->priority
+					|| (ptr_env->priority == victim->priority && size > victimSize))
+			{
+				victim = ptr_env;
+				victimSize = size;
+			}
+		}
+	}
+	return victim;
+}
+
+//Swap out all the resident pages of the given env (writing back the modified ones)
+//and park it in the SUSPENDED queue
+void sched_suspend_env(struct Env* env)
+{
+	if (env == NULL)
+		return;
+
+	if (env == curenv)
+		curenv = NULL;
+	else
+		sched_remove_ready(env);
+
+	//pf_update_env_page() temporarily maps the frame in the env's directory, so switch to it
+	uint32 old_cr3 = rcr3();
+	lcr3(env->env_cr3);
+
+	env->suspendedWSSize = 0;
+	for (int i = 0 ; i < env->page_WS_max_size ; i++)
+	{
+		if (env_page_ws_is_entry_empty(env, i))
+			continue;
+
+		uint32 va = env_page_ws_get_virtual_address(env, i);
+		//pages pinned by mlock stay resident
+		if (pt_get_page_permissions(env, va) & PERM_LOCKED)
+			continue;
+		uint32 *ptr_page_table = NULL;
+		struct Frame_Info* ptr_frame_info = get_frame_info(env->env_page_directory, (void*)va, &ptr_page_table);
+		if (ptr_frame_info != NULL)
+		{
+			if (pt_get_page_permissions(env, va) & PERM_MODIFIED)
+			{
+				pf_update_env_page(env, (void*)va, ptr_frame_info);
+			}
+			unmap_frame(env->env_page_directory, (void*)va);
+		}
+		env_page_ws_clear_entry(env, i);
+		env->suspendedWSSize++;
+	}
+	env->page_last_WS_index = 0;
+
+	lcr3(old_cr3);
+
+	env->nSuspensions++;
+	env->env_status = ENV_SUSPENDED;
+	enqueue(&env_suspended_queue, env);
+	env->schedQueue = SCHQ_SUSPENDED;
+}
+
+//Remove the oldest suspended env (if any) from the SUSPENDED queue and return it.
+//Its pages are brought back on demand by the page fault handler
+struct Env* sched_resume_env()
+{
+	struct Env* env = dequeue(&env_suspended_queue);
+	if (env != NULL)
+	{
+		env->schedQueue = SCHQ_NONE;
+		env->env_status = ENV_UNKNOWN;
+	}
+	return env;
+}
+
+//Called on each clock tick while the load control is ON
+void sched_check_load()
+{
+	//only count the ticks of user CPU time
+	if (curenv != NULL)
+		lc_window_ticks++;
+	if (lc_window_ticks < LC_WINDOW_TICKS)
+		return;
+
+	uint32 faults = lc_window_faults;
+	uint32 freeFrames = calculate_free_frames();
+	lc_window_ticks = 0;
+	lc_window_faults = 0;
+
+	if (faults > lc_faults_per_tick * LC_WINDOW_TICKS && freeFrames < lc_low_free_frames)
+	{
+		//Thrashing: swap out one env per window, but never the last active one
+		if (sched_count_active_envs() > 1)
+		{
+			sched_suspend_env(sched_select_suspension_victim());
+		}
+	}
+	else if (faults <= (lc_faults_per_tick * LC_WINDOW_TICKS) / 2 && !LIST_EMPTY(&env_suspended_queue))
+	{
+		//Pressure dropped: reactivate the oldest suspended env if its last resident set fits above the watermark
+		struct Env* env = LIST_LAST(&env_suspended_queue);
+		if (freeFrames >= lc_low_free_frames + env->suspendedWSSize)
+		{
+			sched_insert_ready(sched_resume_env());
+		}
+	}
+}
+
+//==================================================================================//
+//============================ 2026: BLOCKED ENVS ==================================//
+//==================================================================================//
+
+//Park the given env (the faulted one) in the BLOCKED queue till its page-in completes.
+//The caller should then run another env (see trap())
+void sched_block_env(struct Env* env)
+{
+	env->env_status = ENV_BLOCKED;
+	enqueue(&env_blocked_queue, env);
+	env->schedQueue = SCHQ_BLOCKED;
+}
+
+//Called on the completion of the page-in of the given env: make it ready again
+void sched_unblock_env(struct Env* env)
+{
+	remove_from_queue(&env_blocked_queue, env);
+	env->schedQueue = SCHQ_NONE;
+	sched_insert_ready(env);
+}
+
+//==================================================================================//
+//============================ 2026: SLEEPING ENVS =================================//
+//==================================================================================//
+
+//Put the given env (the curenv) to sleep for the given # ms in the timer wheel.
+//The caller should then run another env (see trap())
+void sched_sleep_env(struct Env* env, uint32 milliseconds)
+{
+	env->wakeupTime = sched_time_ms + MAX(milliseconds, 1);
+	env->env_status = ENV_BLOCKED;
+	enqueue(&(sched_timer_wheel[env->wakeupTime % TW_NUM_SLOTS]), env);
+	env->schedQueue = SCHQ_SLEEPING;
+	sched_num_sleeping++;
+}
+
+//Give up the rest of the quantum of the given env (the curenv): it goes back to the ready queue
+//of its level (without being demoted) and the caller should then run another env (see trap()).
+//A deadline env is done for its current period: it sleeps till its deadline
+void sched_yield_env(struct Env* env)
+{
+	uint64 now = kclock_now_ns();
+	if (env->dlPeriod != 0 && now < env->dlDeadline)
+	{
+		edf_throttle(env, now);
+		return;
+	}
+	sched_insert_ready(env);
+}
+
+void sched_remove_sleeping_env(struct Env* env)
+{
+	remove_from_queue(&(sched_timer_wheel[env->wakeupTime % TW_NUM_SLOTS]), env);
+	env->schedQueue = SCHQ_NONE;
+	sched_num_sleeping--;
+}
+
+//Advance the scheduler clock by the given # ms and wake up the envs whose time has come
+//(only the slots gone through are checked, the others envs there wake up in a later turn of the wheel)
+void sched_advance_time(uint32 milliseconds)
+{
+	uint32 nSlots = MIN(milliseconds, TW_NUM_SLOTS);
+	struct Env* ptr_env;
+
+	sched_time_ms += milliseconds;
+	for (uint32 t = sched_time_ms - nSlots + 1 ; sched_num_sleeping > 0 && nSlots > 0 ; t++, nSlots--)
+	{
+		struct Env_Queue* slot = &(sched_timer_wheel[t % TW_NUM_SLOTS]);
+		LIST_FOREACH(ptr_env, slot)
+		{
+			if ((int32)(ptr_env->wakeupTime - sched_time_ms) <= 0)
+			{
+				sched_remove_sleeping_env(ptr_env);
+				sched_insert_ready(ptr_env);
+			}
+		}
+	}
+}
+
+//2026: (the sub-ms parts of the elapsed times are accumulated)
+uint32 sched_time_us_remainder;
+void sched_advance_time_us(uint32 microseconds)
+{
+	microseconds += sched_time_us_remainder;
+	sched_time_us_remainder = microseconds % 1000;
+	sched_advance_time(microseconds / 1000);
+}
+
+//Time (in ms) till the next wake-up of a sleeping env, at most kclock_max_interval_ms()
+uint32 sched_time_to_next_wakeup()
+{
+	struct Env* ptr_env;
+	uint32 maxInterval = MIN(kclock_max_interval_ms(), TW_NUM_SLOTS);
+	for (uint32 d = 1 ; sched_num_sleeping > 0 && d < maxInterval ; d++)
+	{
+		LIST_FOREACH(ptr_env, &(sched_timer_wheel[(sched_time_ms + d) % TW_NUM_SLOTS]))
+		{
+			if ((int32)(ptr_env->wakeupTime - sched_time_ms) <= (int32)d)
+				return d;
+		}
+	}
+	return maxInterval;
+}
+
+//Halt the CPU till the next interrupt: the clock (programmed to the next wake-up time) or the disk.
+//The interrupt is handled by trap() as a kernel trap that returns here (see clock_interrupt_handler())
+void sched_idle_wait()
+{
+	kclock_set_quantum(sched_time_to_next_wakeup());
+	sched_idling = 1;
+	kclock_resume();
+	__asm __volatile("sti; hlt; cli");
+	//woken up by another interrupt: correct the time from the counter
+	if (sched_idling)
+	{
+		sched_idling = 0;
+		sched_advance_time_us(kclock_elapsed_us());
+	}
+}
+
+//Called before returning to the curenv after a trap: if other envs became ready while it was
+//running alone on a long tick, the elapsed part is accounted and it gets a normal quantum again
+void sched_update_tick()
+{
+	if (sched_long_tick && sched_ready_levels != 0)
+	{
+		sched_long_tick = 0;
+		sched_advance_time_us(kclock_elapsed_us());
+		kclock_set_quantum_us(sched_quantum_us(curenv, MIN(curenv->schedLevel, num_of_ready_queues - 1)));
+	}
+}
+
+//==================================================================================//
+//============================ 2026: WAIT FOR CHILDREN =============================//
+//==================================================================================//
+
+//The exited child of the given env with the given ID (or any of its children if ANY_CHILD), NULL if none
+struct Env* sched_find_exited_child(struct Env* parent, int32 envId)
+{
+	struct Env* ptr_env;
+	if (envId != ANY_CHILD)
+	{
+		ptr_env = sched_find_env(envId);
+		if (ptr_env != NULL && ptr_env->schedQueue == SCHQ_EXIT && ptr_env->env_parent_id == parent->env_id)
+			return ptr_env;
+		return NULL;
+	}
+	LIST_FOREACH(ptr_env, &env_exit_queue)
+	{
+		if (ptr_env->env_parent_id == parent->env_id)
+			return ptr_env;
+	}
+	return NULL;
+}
+
+//Whether the given env has a (living or exited) child with the given ID (or any child if ANY_CHILD)
+uint32 sched_has_child(struct Env* parent, int32 envId)
+{
+	struct Env* ptr_env;
+	if (envId != ANY_CHILD)
+	{
+		ptr_env = sched_find_env(envId);
+		return (ptr_env != NULL && ptr_env->env_parent_id == parent->env_id);
+	}
+	for (int i = 0 ; i < NENV ; i++)
+	{
+		if (envs[i].env_status != ENV_FREE && envs[i].env_parent_id == parent->env_id && &(envs[i]) != parent)
+			return 1;
+	}
+	return 0;
+}
+
+//Block the given env (the curenv) till its child with the given ID (or any if ANY_CHILD) exits
+//or is killed (see sched_wake_parent()). The caller should then run another env (see trap())
+void sched_wait_child(struct Env* parent, int32 envId)
+{
+	parent->waitEnvId = envId;
+	parent->env_status = ENV_BLOCKED;
+	enqueue(&env_waiting_queue, parent);
+	parent->schedQueue = SCHQ_WAITING;
+}
+
+//Called when the given env exits or is freed: make its parent ready again if it's waiting for it
+void sched_wake_parent(struct Env* child)
+{
+	struct Env* parent = sched_find_env(child->env_parent_id);
+	if (parent == NULL || parent->schedQueue != SCHQ_WAITING)
+		return;
+	if (parent->waitEnvId != ANY_CHILD && parent->waitEnvId != child->env_id)
+		return;
+	sched_remove_from_queue(parent);
+	sched_insert_ready(parent);
+}
+
+//==================================================================================//
+//============================ 2026: DEADLINE ENVS =================================//
+//==================================================================================//
+
+//utilization (per thousand) of the given deadline env
+static uint32 edf_utilization(uint32 runtime, uint32 period)
+{
+	return (period == 0) ? 0 : (runtime * 1000 + period - 1) / period;
+}
+
+//Put the given env (the curenv) in the deadline class with the given budget (runtime ms) in each period
+//(period ms), or take it out of it (runtime = 0). Its first period starts now.
+//Returns E_NO_BANDWIDTH if the deadline envs would then use more than EDF_MAX_UTILIZATION of the CPU.
+//On success, it's made ready (in its new class) and the caller should then run another env (see trap())
+int sched_set_deadline(struct Env* env, uint32 runtime, uint32 period)
+{
+	if (runtime != 0 && (period == 0 || runtime > period))
+		return E_INVAL;
+
+	uint32 utilization = (runtime == 0) ? 0 : edf_utilization(runtime, period);
+	if (edf_total_utilization - edf_utilization(env->dlRuntime, env->dlPeriod) + utilization > EDF_MAX_UTILIZATION)
+		return E_NO_BANDWIDTH;
+
+	sched_clear_deadline(env);
+	if (runtime != 0)
+	{
+		edf_total_utilization += utilization;
+		env->dlRuntime = runtime;
+		env->dlPeriod = period;
+		env->dlDeadline = kclock_now_ns() + period * 1000000ULL;
+		env->dlBudget = runtime * 1000000LL;
+		env->dlThrottled = 0;
+		env->dlPeriods = 1;
+		env->dlMissed = env->dlThrottles = 0;
+	}
+	sched_insert_ready(env);
+	return 0;
+}
+
+//Take the given env out of the deadline class (if it's there): its utilization is released
+//(it shouldn't be in the EDF queue)
+void sched_clear_deadline(struct Env* env)
+{
+	if (env->dlPeriod == 0)
+		return;
+	edf_total_utilization -= edf_utilization(env->dlRuntime, env->dlPeriod);
+	env->dlRuntime = env->dlPeriod = 0;
+}
+
+//Start the next period of the given deadline env: keep its periodic deadlines unless it's too late
+static void edf_new_period(struct Env* env, uint64 now)
+{
+	uint64 period = env->dlPeriod * 1000000ULL;
+	if (now < env->dlDeadline + period)
+		env->dlDeadline += period;
+	else
+		env->dlDeadline = now + period;
+	env->dlBudget = env->dlRuntime * 1000000LL;
+	env->dlThrottled = 0;
+	env->dlPeriods++;
+}
+
+//The deadline of the given env (ready or running) has come: it's missed if it still had budget
+static void edf_check_deadline(struct Env* env, uint64 now)
+{
+	if (now < env->dlDeadline)
+		return;
+	if (env->dlBudget >= EDF_MIN_BUDGET_US * 1000)
+		env->dlMissed++;
+	edf_new_period(env, now);
+}
+
+//Insert the given env in the EDF queue (sorted by deadline). If it was throttled or
+//sleeping/blocked till after its deadline, it starts its next period
+static void edf_insert(struct Env* env)
+{
+	struct Env* ptr_env;
+	uint64 now = kclock_now_ns();
+	if (env->dlThrottled || now >= env->dlDeadline)
+		edf_new_period(env, now);
+
+	sched_ready_levels |= SCHED_EDF_READY;
+	env->schedQueue = SCHQ_DEADLINE;
+	LIST_FOREACH(ptr_env, &env_deadline_queue)
+	{
+		if (env->dlDeadline < ptr_env->dlDeadline)
+		{
+			LIST_INSERT_BEFORE(&env_deadline_queue, ptr_env, env);
+			return;
+		}
+	}
+	LIST_INSERT_TAIL(&env_deadline_queue, env);
+}
+
+static void edf_remove(struct Env* env)
+{
+	LIST_REMOVE(&env_deadline_queue, env);
+	env->schedQueue = SCHQ_NONE;
+	if (LIST_EMPTY(&env_deadline_queue))
+		sched_ready_levels &= ~SCHED_EDF_READY;
+}
+
+//Dequeue the env with the earliest deadline, for the rest of its budget (or till its deadline)
+static struct Env* edf_pick()
+{
+	struct Env* env = LIST_FIRST(&env_deadline_queue);
+	uint64 now = kclock_now_ns();
+	edf_remove(env);
+	edf_check_deadline(env, now);
+
+	uint64 quantum = MIN((uint64)MAX(env->dlBudget, 0), env->dlDeadline - now) / 1000;
+	quantum = MIN(MAX(quantum, EDF_MIN_BUDGET_US), kclock_max_interval_ms() * 1000);
+	kclock_set_quantum_us(quantum);
+	return env;
+}
+
+//Sleep till the end of the current period of the given env (the curenv)
+static void edf_throttle(struct Env* env, uint64 now)
+{
+	env->dlThrottled = 1;
+	sched_sleep_env(env, (env->dlDeadline - now + 999999) / 1000000);
+}
+
+//Called by the scheduler for the given deadline env (the curenv) at the end of its quantum:
+//it's throttled if it has used up its budget before its deadline, else it goes back to the EDF queue
+static void edf_requeue(struct Env* env)
+{
+	uint64 now = kclock_now_ns();
+	if (env->dlBudget < EDF_MIN_BUDGET_US * 1000 && now < env->dlDeadline)
+	{
+		env->dlThrottles++;
+		edf_throttle(env, now);
+		return;
+	}
+	edf_check_deadline(env, now);
+	sched_insert_ready(env);
+}
+
+//==================================================================================//
+//============================ 2026: CPU ACCOUNTING ================================//
+//==================================================================================//
+
+//Called by env_run() before resuming the given env in user mode
+void sched_account_resume(struct Env* env)
+{
+	uint64 now = kclock_now_ns();
+	if (env->env_status == ENV_READY)
+	{
+		uint64 wait = now - env->lastTimestamp;
+		env->waitTime += wait;
+		if (wait > env->maxWaitTime)
+			env->maxWaitTime = wait;
+
+		int b = 0;
+		for (uint64 limit = 10000 ; b < SCHED_LAT_BUCKETS - 1 && wait >= limit ; limit *= 10)
+			b++;
+		sched_latency_hist[b]++;
+	}
+	env->lastTimestamp = now;
+}
+
+//Called at the entry of a trap from the given env (the curenv)
+void sched_account_trap(struct Env* env)
+{
+	uint64 now = kclock_now_ns();
+	env->runTime += now - env->lastTimestamp;
+	//(for the CFS)
+	env->vruntime += (now - env->lastTimestamp) * CFS_NICE_0_WEIGHT / cfs_weight(env);
+	//(for the EDF)
+	if (env->dlPeriod != 0)
+		env->dlBudget -= now - env->lastTimestamp;
+	env->lastTimestamp = now;
+}
+
+void sched_print_stats()
+{
+	static char* bucketNames[SCHED_LAT_BUCKETS] = {"< 10 us", "< 100 us", "< 1 ms", "< 10 ms", "< 100 ms", "< 1 s", ">= 1 s"};
+	struct Env* e;
+
+	cprintf("Env: run time (us), wait time (us), max wait (us), # switches, level, priority\n");
+	for (int i = 0 ; i < NENV ; i++)
+	{
+		e = &(envs[i]);
+		if (e->env_status == ENV_FREE)
+			continue;
+		cprintf("	[%d] %s: %llu, %llu, %llu, %d, %d, %d\n", e->env_id, e->prog_name,
+				e->runTime / 1000, e->waitTime / 1000, e->maxWaitTime / 1000, e->nSwitches, e->schedLevel, e->priority);
+	}
+	cprintf("Deadline envs: runtime/period (ms), # periods, # missed deadlines, # throttles\n");
+	for (int i = 0 ; i < NENV ; i++)
+	{
+		e = &(envs[i]);
+		if (e->env_status == ENV_FREE || e->dlPeriods == 0)
+			continue;
+		cprintf("	[%d] %s: %d/%d, %d, %d, %d\n", e->env_id, e->prog_name,
+				e->dlRuntime, e->dlPeriod, e->dlPeriods, e->dlMissed, e->dlThrottles);
+	}
+	cprintf("Run-queue latency:\n");
+	for (int b = 0 ; b < SCHED_LAT_BUCKETS ; b++)
+	{
+		cprintf("	%s: %d\n", bucketNames[b], sched_latency_hist[b]);
+	}
+}
+
+void sched_reset_stats()
+{
+	for (int i = 0 ; i < NENV ; i++)
+	{
+		envs[i].runTime = envs[i].waitTime = envs[i].maxWaitTime = 0;
+		envs[i].nSwitches = 0;
+		envs[i].dlMissed = envs[i].dlThrottles = 0;
+	}
+	memset(sched_latency_hist, 0, sizeof(sched_latency_hist));
+}
@@ -11,6 +11,7 @@
 //2018
 #define SCH_RR 0
 #define SCH_MLFQ 1
+#define SCH_CFS 2	//2026
 unsigned scheduler_method ;
 
 LIST_HEAD(Env_Queue, Env);		// Declares 'struct Env_Queue'
@@ -27,6 +28,18 @@ uint8 *quantums ;					// Quantum(s) in ms for each level of the ready queue(s)
 uint8 num_of_ready_queues ;			// Number of ready queue(s)
 //===============
 
+//2026: each env keeps the queue it's in (in its schedQueue), so it's found (by envs[ENVX(id)])
+//and removed from its queue in O(1)
+#define SCHQ_NONE		0	// running or in no queue
+#define SCHQ_NEW		1
+#define SCHQ_READY		2	// (at its schedLevel)
+#define SCHQ_DEADLINE	3
+#define SCHQ_BLOCKED	4
+#define SCHQ_SLEEPING	5
+#define SCHQ_SUSPENDED	6
+#define SCHQ_EXIT		7
+#define SCHQ_WAITING	8	// (for a child to exit)
+
 //2015
 #define SCH_STOPPED 0
 #define SCH_STARTED 1
@@ -34,6 +47,90 @@ unsigned scheduler_status ;
 
 #define CLOCK_INTERVAL_IN_MS 10 //milliseconds
 
+//2026: MLFQ
+//The levels having ready envs are kept in a bitmap (so at most MLFQ_MAX_LEVELS levels) and the
+//level of each env in its Env. An env is demoted only when it uses its full quantum (i.e. when it's
+//preempted by the clock), and all the envs are boosted to level 0 every MLFQ_BOOST_PERIOD_MS of CPU time
+#define MLFQ_MAX_LEVELS			31		//(the last bit of sched_ready_levels is for the EDF)
+#define MLFQ_BOOST_PERIOD_MS	1000
+uint32 sched_ready_levels ;		// bit i is set if env_ready_queues[i] isn't empty
+uint8 sched_quantum_expired ;	// set by the clock when the curenv has used its full quantum
+
+//2026: CFS
+//The ready envs are kept in an AVL tree ordered by their virtual run time (the run time weighted by
+//their priority, charged at each trap entry), besides the single ready queue (used to list them).
+//The env with the smallest one runs for a share of the target latency proportional to its weight
+//(at least CFS_MIN_GRANULARITY_US). An env made ready (new, woken up) gets at least the min virtual
+//run time minus half the latency, so it can't monopolize the CPU after a long sleep.
+#define CFS_DEFAULT_LATENCY_MS		20
+#define CFS_MIN_GRANULARITY_US		1000
+#define CFS_NICE_0_WEIGHT			1024
+struct Env* cfs_root ;
+uint64 cfs_min_vruntime ;
+uint32 cfs_total_weight ;			// total weight of the envs in the tree
+uint8 cfs_latency_ms ;
+
+//2026: EDF (deadline class)
+//An env given a (runtime, period) by sys_set_deadline() should get runtime ms of CPU in each period,
+//before its deadline (the end of the period). The ready ones are kept in env_deadline_queue sorted by
+//their deadline, and the first one always runs ahead of the RR/MLFQ/CFS queues till the end of its
+//budget or its deadline. An env that uses up its budget is throttled (sleeps in the timer wheel) till
+//its next period. The admitted envs can't use more than EDF_MAX_UTILIZATION per thousand of the CPU,
+//so the other envs aren't starved.
+#define EDF_MAX_UTILIZATION		900
+#define EDF_MIN_BUDGET_US		50			// less is considered used up
+#define SCHED_EDF_READY			(1 << MLFQ_MAX_LEVELS)	// in sched_ready_levels: env_deadline_queue isn't empty
+struct Env_Queue env_deadline_queue ;
+uint32 edf_total_utilization ;		// per thousand
+
+//2026: Load control
+//The controller samples the page fault rate over a window of clock ticks (i.e. of
+//user CPU time, since the clock is stopped while the kernel handles the faults).
+//If both the fault rate is high and the free frames are scarce, the system is
+//considered thrashing: a victim env is swapped out to the page file and parked in
+//the SUSPENDED queue until the pressure drops again.
+#define LC_WINDOW_TICKS				10	//ticks per sampling window
+#define LC_DEFAULT_FAULTS_PER_TICK	4	//above it, the window is considered thrashing
+#define LC_DEFAULT_LOW_FREE_FRAMES	128	//free frames watermark
+#define LC_OFF 0
+#define LC_ON 1
+unsigned load_control_status ;
+uint32 lc_faults_per_tick ;
+uint32 lc_low_free_frames ;
+uint32 lc_window_faults ;			//# page faults in the current window (incremented by fault_handler)
+struct Env_Queue env_suspended_queue;	// queue of all envs swapped out by the load controller
+
+//2026: non-blocking page faults
+struct Env_Queue env_blocked_queue;		// queue of all envs waiting for a page-in (see pf_read_env_page_async())
+
+//2026: envs waiting for a child to exit
+struct Env_Queue env_waiting_queue;		// queue of all envs blocked in sys_waitenv()
+
+//2026: sleeping envs
+//The envs sleeping in sys_sleep() are BLOCKED in a hashed timer wheel of TW_NUM_SLOTS slots of 1 ms:
+//an env to wake up at time t is in the slot (t % TW_NUM_SLOTS). The scheduler clock (sched_time_ms)
+//is advanced by the quantum at each clock interrupt (and by the waited time while all the envs are
+//sleeping), and the slots it goes through are checked for the envs to wake up.
+#define TW_NUM_SLOTS	256
+struct Env_Queue sched_timer_wheel[TW_NUM_SLOTS];
+uint32 sched_time_ms ;				// scheduler clock in ms (CPU time of the envs + idle time)
+uint32 sched_num_sleeping ;			// # envs in the timer wheel
+
+//2026: tickless idle & dynamic ticks
+//When the env to run is alone (no other ready env), it gets a "long tick" (till the next wake-up
+//time, at most kclock_max_interval_ms()) that only keeps the time: it's not preempted as long as it's alone.
+//When nothing is ready but envs are sleeping or waiting for a page-in, the CPU is halted till the
+//next wake-up time or the disk interrupt, and the time is corrected from the counter.
+uint8 sched_long_tick ;				// the curenv is running alone on a long tick
+uint8 sched_idling ;				// the CPU is halted in sched_idle_wait()
+
+//2026: CPU accounting
+//The run time of each env is taken at trap entry and env_run(), its wait time from its insertion
+//in a ready queue till env_run(). The waits are also counted in a run-queue latency histogram of
+//SCHED_LAT_BUCKETS buckets: < 10 us, < 100 us, ..., < 1 s, >= 1 s
+#define SCHED_LAT_BUCKETS	7
+uint32 sched_latency_hist[SCHED_LAT_BUCKETS];
+
 
 // This function does not return.
 void fos_scheduler(void) __attribute__((noreturn));
@@ -55,6 +152,12 @@ void sched_insert_exit(struct Env* env);
 void sched_remove_exit(struct Env* env);
 void sched_kill_env(uint32 envId);
 void sched_kill_all();
+struct Env* sched_find_env(uint32 envId);
+void sched_remove_from_queue(struct Env* env);
+struct Env* sched_find_exited_child(struct Env* parent, int32 envId);
+uint32 sched_has_child(struct Env* parent, int32 envId);
+void sched_wait_child(struct Env* parent, int32 envId);
+void sched_wake_parent(struct Env* child);
 
 //Declaration of helper functions to deal with the env queues
 void init_queue(struct Env_Queue* queue);
@@ -65,7 +168,39 @@ struct Env* find_env_in_queue(struct Env_Queue* queue, uint32 envID);
 void remove_from_queue(struct Env_Queue* queue, struct Env* e);
 void sched_init_RR(uint8 quantum);
 void sched_init_MLFQ(uint8 numOfLevels, uint8 *quantumOfEachLevel);
+void sched_init_CFS(uint8 latency);
+uint32 isSchedMethodCFS();
+uint32 cfs_weight(struct Env* env);
+uint32 sched_quantum_us(struct Env* env, int level);
+uint8 sched_priority_level(struct Env* env);
+void sched_set_priority(struct Env* env, int priority);
+void sched_boost_MLFQ();
 uint32 isSchedMethodMLFQ();
 uint32 isSchedMethodRR();
 void sched_exit_all_ready_envs();
+
+void sched_init_load_control(uint8 onoff, uint32 faultsPerTick, uint32 lowFreeFrames);
+void sched_check_load();
+void sched_suspend_env(struct Env* env);
+struct Env* sched_resume_env();
+
+void sched_block_env(struct Env* env);
+void sched_unblock_env(struct Env* env);
+
+void sched_sleep_env(struct Env* env, uint32 milliseconds);
+void sched_yield_env(struct Env* env);
+void sched_advance_time(uint32 milliseconds);
+void sched_advance_time_us(uint32 microseconds);
+uint32 sched_time_to_next_wakeup();
+void sched_idle_wait();
+void sched_update_tick();
+
+void sched_account_resume(struct Env* env);
+void sched_account_trap(struct Env* env);
+void sched_print_stats();
+void sched_reset_stats();
+void sched_remove_sleeping_env(struct Env* env);
+
+int sched_set_deadline(struct Env* env, uint32 runtime, uint32 period);
+void sched_clear_deadline(struct Env* env);
 #endif	// !FOS_KERN_SCHED_H
@@ -13,6 +13,7 @@
 #include <kern/console.h>
 #include <kern/sched.h>
 #include <kern/utilities.h>
+#include <kern/priority_manager.h>
 
 extern uint32 isBufferingEnabled();
 extern void __freeMem_with_buffering(struct Env* e, uint32 virtual_address, uint32 size);
@@ -112,8 +113,10 @@ static int sys_env_destroy(int32 envid)
 	return 0;
 }
 
-static void sys_env_exit()
+static void sys_env_exit(int status)
 {
+	//2026
+	curenv->exitStatus = status;
 	//2015
 	env_exit();
 	//env_run_cmd_prmpt();
@@ -163,6 +166,9 @@ static int __sys_allocate_page(void *va, int perm)
 	//check permissions to be appropriate
 	if ((perm & (~PERM_AVAILABLE & ~PERM_WRITEABLE)) != (PERM_USER))
 		return E_INVAL;
+	//2026: the pages are only pinned by sys_mlock() (within the env's quota)
+	if (perm & PERM_LOCKED)
+		return E_INVAL;
 
 
 	uint32 physical_address = to_physical_address(ptr_frame_info) ;
@@ -275,6 +281,10 @@ int sys_pf_calculate_allocated_pages(void)
 
 void sys_freeMem(uint32 virtual_address, uint32 size)
 {
+	//2026: freed pages can't stay pinned
+	munlockMem(curenv, virtual_address, size);
+	madviseMem(curenv, virtual_address, size, MADV_NORMAL);
+
 	if(isBufferingEnabled())
 	{
 		__freeMem_with_buffering(curenv, virtual_address, size);
@@ -304,7 +314,7 @@ void sys_enable_interrupt()
 
 void sys_clearFFL()
 {
-	int size = LIST_SIZE(&free_frame_list) ;
+	int size = calculate_free_frames() ;
 	int i = 0 ;
 	struct Frame_Info* ptr_tmp_FI ;
 	for (; i < size ; i++)
@@ -425,6 +435,86 @@ void sys_set_uheap_strategy(uint32 heapStrategy)
 	_UHeapPlacementStrategy = heapStrategy;
 }
 
+//2026
+int sys_madvise(uint32 virtual_address, uint32 size, int advice)
+{
+	return madviseMem(curenv, virtual_address, size, advice);
+}
+
+int sys_mlock(uint32 virtual_address, uint32 size)
+{
+	return mlockMem(curenv, virtual_address, size);
+}
+
+int sys_munlock(uint32 virtual_address, uint32 size)
+{
+	return munlockMem(curenv, virtual_address, size);
+}
+
+//the curenv is BLOCKED in the timer wheel (or made READY again): trap() then runs another env
+void sys_sleep(uint32 milliseconds)
+{
+	sched_sleep_env(curenv, milliseconds);
+}
+
+void sys_yield()
+{
+	sched_yield_env(curenv);
+}
+
+//2026: set the priority of the given env (0 for the curenv, else the curenv or its child)
+int sys_set_priority(int32 envId, int priority)
+{
+	struct Env* env;
+	if (priority < PRIORITY_LOW || priority > PRIORITY_HIGH)
+		return E_INVAL;
+	if (envid2env(envId, &env, 1) < 0)
+		return E_BAD_ENV;
+	set_program_priority(env, priority);
+	return 0;
+}
+
+//2026: reap an exited child of the curenv (the given one or ANY_CHILD): it's freed and its status
+//and counters are given in *info (if not NULL). Returns its ID, E_BAD_ENV if there's no such child,
+//E_INVAL if info isn't in the user space,
+//or 0 if the curenv is BLOCKED till one exits: trap() then runs another env, and the call is
+//repeated when it's woken up (see sys_waitenv() in lib/syscall.c)
+int sys_waitenv(int32 envId, struct EnvExitInfo* info)
+{
+	//the info is written by the kernel: it should be in the user space
+	if (info != NULL && ((uint32)info >= USER_TOP || (uint32)info + sizeof(struct EnvExitInfo) > USER_TOP))
+		return E_INVAL;
+
+	struct Env* child = sched_find_exited_child(curenv, envId);
+	if (child == NULL)
+	{
+		if (!sched_has_child(curenv, envId))
+			return E_BAD_ENV;
+		sched_wait_child(curenv, envId);
+		return 0;
+	}
+	int32 childId = child->env_id;
+	if (info != NULL)
+	{
+		info->envId = childId;
+		info->exitStatus = child->exitStatus;
+		info->pageFaults = child->pageFaultsCounter;
+		info->tableFaults = child->tableFaultsCounter;
+		info->nClocks = child->nClocks;
+		info->runTime = child->runTime;
+		info->waitTime = child->waitTime;
+	}
+	sched_remove_exit(child);
+	start_env_free(child);
+	return childId;
+}
+
+//the curenv is made READY in its new class on success: trap() then runs the next env
+int sys_set_deadline(uint32 runtime, uint32 period)
+{
+	return sched_set_deadline(curenv, runtime, period);
+}
+
 
 // Dispatches to the correct kernel function, passing the arguments.
 uint32 syscall(uint32 syscallno, uint32 a1, uint32 a2, uint32 a3, uint32 a4, uint32 a5)
@@ -454,7 +544,7 @@ uint32 syscall(uint32 syscallno, uint32 a1, uint32 a2, uint32 a3, uint32 a4, uin
 		return sys_env_destroy(a1);
 		break;
 	case SYS_env_exit:
-		sys_env_exit();
+		sys_env_exit((int)a1);
 		return 0;
 		break;
 	case SYS_calc_req_frames:
@@ -573,6 +663,32 @@ uint32 syscall(uint32 syscallno, uint32 a1, uint32 a2, uint32 a3, uint32 a4, uin
 		sys_set_uheap_strategy(a1);
 		return 0;
 
+	case SYS_madvise:
+		return sys_madvise(a1, a2, (int)a3);
+
+	case SYS_mlock:
+		return sys_mlock(a1, a2);
+
+	case SYS_munlock:
+		return sys_munlock(a1, a2);
+
+	case SYS_sleep:
+		sys_sleep(a1);
+		return 0;
+
+	case SYS_yield:
+		sys_yield();
+		return 0;
+
+	case SYS_set_deadline:
+		return sys_set_deadline(a1, a2);
+
+	case SYS_set_priority:
+		return sys_set_priority(a1, a2);
+
+	case SYS_waitenv:
+		return sys_waitenv(a1, (struct EnvExitInfo*)a2);
+
 	case NSYSCALLS:
 		return 	-E_INVAL;
 		break;
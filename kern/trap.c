@@ -1,6 +1,7 @@
 #include <inc/mmu.h>
 #include <inc/x86.h>
 #include <inc/assert.h>
+#include <inc/disk.h>
 
 #include <kern/memory_manager.h>
 #include <kern/trap.h>
@@ -11,12 +12,20 @@
 #include <kern/syscall.h>
 #include <kern/sched.h>
 #include <kern/kclock.h>
+#include <kern/lapic.h>
+#include <kern/picirq.h>
+#include <kern/pgtrace.h>
 #include <kern/trap.h>
 
 extern void __static_cpt(uint32 *ptr_page_directory, const uint32 virtual_address, uint32 **ptr_page_table);
 
 void __page_fault_handler_with_buffering(struct Env * curenv, uint32 fault_va);
 void page_fault_handler(struct Env * curenv, uint32 fault_va);
+
+//2026: set while handling a fault of user code, whose env can be blocked during the page-in
+//(faults taken inside the kernel, e.g. by mlock, are always handled synchronously)
+static uint8 pf_async_user_fault = 0;
+
 void table_fault_handler(struct Env * curenv, uint32 fault_va);
 
 static struct Taskstate ts;
@@ -36,6 +45,7 @@ struct Pseudodesc idt_pd = {
 };
 extern  void (*PAGE_FAULT)();
 extern  void (*SYSCALL_HANDLER)();
+extern  void (*sysenter_handler)();
 extern  void (*DBL_FAULT)();
 
 extern  void (*ALL_FAULTS0)();
@@ -76,6 +86,8 @@ extern  void (*ALL_FAULTS44)();
 extern  void (*ALL_FAULTS45)();
 extern  void (*ALL_FAULTS46)();
 extern  void (*ALL_FAULTS47)();
+extern  void (*LAPIC_TIMER_HANDLER)();
+extern  void (*LAPIC_SPURIOUS_HANDLER)();
 
 
 
@@ -163,6 +175,10 @@ idt_init(void)
 	SETGATE(idt[46], 0, GD_KT , &ALL_FAULTS46, 3) ;
 	SETGATE(idt[47], 0, GD_KT , &ALL_FAULTS47, 3) ;
 
+	//2026: local APIC
+	SETGATE(idt[T_LAPIC_TIMER], 0, GD_KT , &LAPIC_TIMER_HANDLER, 0) ;
+	SETGATE(idt[T_LAPIC_SPURIOUS], 0, GD_KT , &LAPIC_SPURIOUS_HANDLER, 0) ;
+
 
 
 	// Setup a TSS so that we get the right stack
@@ -180,6 +196,26 @@ idt_init(void)
 
 	// Load the IDT
 	asm volatile("lidt idt_pd");
+
+	//2026: fast system calls
+	sysenter_init();
+}
+
+//2026: SYSENTER/SYSEXIT fast system calls
+//The 'int T_SYSCALL' path stays for the CPUs without them (and the syscalls with 5 args)
+void sysenter_init(void)
+{
+	uint32 eax, ebx, ecx, edx;
+	cpuid(1, &eax, &ebx, &ecx, &edx);
+	if ((edx & (1 << 11)) == 0)
+	{
+		cprintf("Fast system calls: not supported\n");
+		return;
+	}
+	//the kernel ss is the next GDT entry of its cs (GD_KD), and the user cs/ss are at +16/+24 (GD_UT/GD_UD)
+	wrmsr(MSR_IA32_SYSENTER_CS, GD_KT);
+	wrmsr(MSR_IA32_SYSENTER_ESP, KERNEL_STACK_TOP);
+	wrmsr(MSR_IA32_SYSENTER_EIP, (uint32)&sysenter_handler);
 }
 
 void print_trapframe(struct Trapframe *tf)
@@ -243,6 +279,22 @@ static void trap_dispatch(struct Trapframe *tf)
 	{
 		clock_interrupt_handler() ;
 	}
+	//2026: local APIC timer (the EOI first, the handler may not return)
+	else if (tf->tf_trapno == T_LAPIC_TIMER)
+	{
+		lapic_eoi();
+		clock_interrupt_handler() ;
+	}
+	else if (tf->tf_trapno == T_LAPIC_SPURIOUS)
+	{
+		return;
+	}
+	//2026: completion of a non-blocking page-in
+	else if (tf->tf_trapno == IRQ0_Clock + IDE_IRQ)
+	{
+		pf_async_complete(0);
+		irq_eoi_8259A(IDE_IRQ);
+	}
 
 	else
 	{
@@ -270,8 +322,10 @@ void trap(struct Trapframe *tf)
 		curenv->env_tf = *tf;
 		tf = &(curenv->env_tf);
 		userTrap = 1;
+		//2026: CPU accounting
+		sched_account_trap(curenv);
 	}
-	if(tf->tf_trapno == IRQ0_Clock)
+	if(tf->tf_trapno == IRQ0_Clock || tf->tf_trapno == T_LAPIC_TIMER)
 	{
 //		uint16 cnt0 = kclock_read_cnt0() ;
 //		cprintf("CLOCK INTERRUPT: Counter0 Value = %d\n", cnt0 );
@@ -299,7 +353,14 @@ void trap(struct Trapframe *tf)
 	trap_dispatch(tf);
 	if (userTrap)
 	{
+		//2026: the env is blocked on a page-in, run another one meanwhile
+		if (curenv->env_status != ENV_RUNNABLE)
+		{
+			curenv = NULL;
+			fos_scheduler();
+		}
 		assert(curenv && curenv->env_status == ENV_RUNNABLE);
+		sched_update_tick();
 		env_run(curenv);
 	}
 	/* 2019
@@ -311,6 +372,45 @@ void trap(struct Trapframe *tf)
 	}
 }
 
+//2026: called by sysenter_handler (kern/trapentry.S) with the trapframe it built on the kernel stack
+//The syscall is dispatched directly: the trapframe is only saved in the env (and the clock stopped)
+//if the env can't be resumed right away, then it goes on like trap() does
+void fast_syscall(struct Trapframe *tf)
+{
+	assert(curenv);
+	sched_account_trap(curenv);
+	//SYSENTER clears the IF: the env gets back the one it had (see sys_disable_interrupt())
+	tf->tf_eflags = (tf->tf_eflags & ~FL_IF) | (curenv->env_tf.tf_eflags & FL_IF);
+
+	tf->tf_regs.reg_eax = syscall(tf->tf_regs.reg_eax
+			,tf->tf_regs.reg_edx
+			,tf->tf_regs.reg_ecx
+			,tf->tf_regs.reg_ebx
+			,tf->tf_regs.reg_edi
+			,0);
+	//(the syscall itself may have changed it)
+	tf->tf_eflags = (tf->tf_eflags & ~FL_IF) | (curenv->env_tf.tf_eflags & FL_IF);
+
+	if (curenv->env_status == ENV_RUNNABLE && !(sched_long_tick && sched_ready_levels != 0))
+	{
+		//a kernel trap during the syscall (e.g. a page fault on a user buffer) stopped the 8253
+		if (kclock_stopped)
+			kclock_resume();
+		return;
+	}
+
+	//the env is blocked/requeued by the syscall or another one got ready during a long tick
+	kclock_stop();
+	curenv->env_tf = *tf;
+	if (curenv->env_status != ENV_RUNNABLE)
+	{
+		curenv = NULL;
+		fos_scheduler();
+	}
+	sched_update_tick();
+	env_run(curenv);
+}
+
 void setPageReplacmentAlgorithmLRU(){_PageRepAlgoType = PG_REP_LRU;}
 void setPageReplacmentAlgorithmCLOCK(){_PageRepAlgoType = PG_REP_CLOCK;}
 void setPageReplacmentAlgorithmFIFO(){_PageRepAlgoType = PG_REP_FIFO;}
@@ -385,6 +485,10 @@ void fault_handler(struct Trapframe *tf)
 			panic("User: stack underflow exception!");
 	}
 
+	//2026: write on the shared (read-only) text of the program
+	if ((tf->tf_err & FEC_PR) && (tf->tf_err & FEC_WR) && env_page_is_shared(curenv, fault_va))
+		panic("User: write on the shared text of %s at %x!", curenv->prog_name, fault_va);
+
 	//get a pointer to the environment that caused the fault at runtime
 	struct Env* faulted_env = curenv;
 
@@ -402,6 +506,11 @@ void fault_handler(struct Trapframe *tf)
 	{
 		// we have normal page fault =============================================================
 		faulted_env->pageFaultsCounter ++ ;
+		lc_window_faults ++ ;
+		if (isPgTraceEnabled())
+		{
+			pgtrace_record_fault(faulted_env, fault_va, tf->tf_err & FEC_WR);
+		}
 
 //				cprintf("[%08s] user PAGE fault va %08x\n", curenv->prog_name, fault_va);
 //				cprintf("\nPage working set BEFORE fault handler...\n");
@@ -413,7 +522,12 @@ void fault_handler(struct Trapframe *tf)
 		}
 		else
 		{
+			pf_async_user_fault = userTrap;
 			page_fault_handler(faulted_env, fault_va);
+			pf_async_user_fault = 0;
+			//2026: read ahead the next pages of a MADV_SEQUENTIAL range (unless blocked on the faulted one)
+			if (faulted_env->env_status == ENV_RUNNABLE)
+				env_page_ws_readahead(faulted_env, fault_va);
 		}
 //				cprintf("\nPage working set AFTER fault handler...\n");
 //				env_page_ws_print(curenv);
@@ -449,20 +563,36 @@ void table_fault_handler(struct Env * curenv, uint32 fault_va)
 void placement_ (struct Env * curenv, uint32 fault_va)
 		{
 			        struct Frame_Info *frame_info_ptr =NULL ;
-					int retrn = allocate_frame(&frame_info_ptr);
+					int retrn = 0;
+					//2026: a page of the shared text of the program is mapped from its shared frame
+					int sharedRet = env_page_map_shared(curenv, fault_va);
+					uint8 shared = (sharedRet == 0);
+					if (sharedRet == E_NO_MEM)
+						retrn = E_NO_MEM;
+					else if (!shared)
+						retrn = allocate_frame(&frame_info_ptr);
 					if(retrn!=E_NO_MEM)
 					{
-					  map_frame(curenv->env_page_directory ,frame_info_ptr ,(void*)fault_va,PERM_PRESENT | PERM_USER | PERM_WRITEABLE);
-					  retrn = pf_read_env_page(curenv,(void *)fault_va);
-					  if (retrn == E_PAGE_NOT_EXIST_IN_PF)
+					  if (!shared)
 					  {
-						  // CHECK if it is a stack page
-						  if (fault_va < USTACKTOP && fault_va >= USTACKBOTTOM)
+						  map_frame(curenv->env_page_directory ,frame_info_ptr ,(void*)fault_va,PERM_PRESENT | PERM_USER | PERM_WRITEABLE);
+						  if (pf_async_user_fault && isAsyncPageInEnabled())
+							  retrn = pf_read_env_page_async(curenv, fault_va);
+						  else
+							  retrn = pf_read_env_page(curenv,(void *)fault_va);
+						  //2026: first fault on a page of a lazily loaded program
+						  if (retrn == E_PAGE_NOT_EXIST_IN_PF)
+							  retrn = env_page_lazy_fill(curenv, fault_va);
+						  if (retrn == E_PAGE_NOT_EXIST_IN_PF)
 						  {
-							  pf_add_empty_env_page(curenv,fault_va,0);
+							  // CHECK if it is a stack page
+							  if (fault_va < USTACKTOP && fault_va >= USTACKBOTTOM)
+							  {
+								  pf_add_empty_env_page(curenv,fault_va,0);
+							  }
+							  else
+								  panic(" Wrong access at %x",fault_va);
 						  }
-						  else
-							  panic(" Wrong access at %x",fault_va);
 					  }
 
 						int size = curenv->page_WS_max_size ;
@@ -479,6 +609,12 @@ void placement_ (struct Env * curenv, uint32 fault_va)
 						env_page_ws_set_entry(curenv,curenv->page_last_WS_index ,fault_va);
 						curenv->page_last_WS_index ++ ;
 						curenv->page_last_WS_index = curenv->page_last_WS_index %  curenv->page_WS_max_size ;
+
+						//2026: record the fault in the profile of the program (if being recorded)
+						if (curenv->ptr_profile != NULL)
+						{
+							env_ws_profile_record(curenv, fault_va);
+						}
 					}
 
 }
@@ -507,7 +643,8 @@ void page_fault_handler(struct Env * curenv, uint32 fault_va)
 						uint32 temp_virt_add = env_page_ws_get_virtual_address(curenv, i);
 						uint32 page_perm = pt_get_page_permissions(curenv, temp_virt_add);
 						if ((page_perm & PERM_MODIFIED) == 0
-								&& (page_perm & PERM_USED) == 0) {
+								&& (page_perm & PERM_USED) == 0
+								&& (page_perm & PERM_LOCKED) == 0) {
 							victim_virt_add = temp_virt_add;
 							victim_index = i;
 							curenv->page_last_WS_index = ((i + 1)
@@ -530,6 +667,12 @@ void page_fault_handler(struct Env * curenv, uint32 fault_va)
 						uint32 temp_virt_add = env_page_ws_get_virtual_address(curenv, i);
 						uint32 page_permissions = pt_get_page_permissions(curenv,
 								temp_virt_add);
+						//2026: pages pinned by mlock are never victims
+						if ((page_permissions & PERM_LOCKED) == PERM_LOCKED) {
+							size--;
+							i++;
+							continue;
+						}
 						if ((page_permissions & PERM_USED) == 0) {
 							victim_virt_add = temp_virt_add;
 							victim_index = i;
@@ -28,6 +28,8 @@ void idt_init(void);
 void print_regs(struct PushRegs *regs);
 void print_trapframe(struct Trapframe *tf);
 void fault_handler(struct Trapframe *);
+void sysenter_init(void);
+void fast_syscall(struct Trapframe *tf);
 void backtrace(struct Trapframe *);
 
 void setPageReplacmentAlgorithmLRU();
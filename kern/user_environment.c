@@ -15,6 +15,7 @@
 #include <kern/helpers.h>
 #include <kern/sched.h>
 #include <kern/kheap.h>
+#include <kern/program_store.h>
 #include <inc/queue.h>
 
 extern int pf_add_env_page(struct Env* ptr_env, uint32 virtual_address, void* ptrDataSrc);
@@ -35,6 +36,7 @@ struct ProgramSegment {
 	uint32 size_in_file;
 	uint32 size_in_memory;
 	uint8 *virtual_address;
+	uint32 flags;	//2026: ELF_PROG_FLAG_*
 
 	// for use only with PROGRAM_SEGMENT_FOREACH
 	uint32 segment_id;
@@ -60,6 +62,12 @@ struct ProgramSegment PROGRAM_SEGMENT_FIRST( uint8* ptr_program_start);
 // Helper functions to be used below
 void complete_environment_initialization(struct Env* e);
 void set_environment_entry_point(struct Env* e, uint8* ptr_program_start);
+void env_ws_profile_start(struct Env* e, struct UserProgramInfo* ptr_user_program_info);
+static int env_lazy_record_segments(struct Env* e, uint8* ptr_program_start);
+static void env_shared_image_attach(struct Env* e, struct UserProgramInfo* ptr_user_program_info);
+static void env_shared_image_detach(struct Env* e);
+static int env_program_image_attach(struct UserProgramInfo* ptr_user_program_info);
+static void env_program_image_detach(struct UserProgramInfo* ptr_user_program_info);
 
 ///===================================================================================
 /// To add FOS support for new user program, just add the appropriate lines like below
@@ -125,6 +133,7 @@ DECLARE_START_OF(tst_envfree1);
 DECLARE_START_OF(ef_mergesort_noleakage);
 DECLARE_START_OF(ef_mergesort_leakage);
 DECLARE_START_OF(tst_envfree2);
+DECLARE_START_OF(tst_waitenv);
 
 //User Programs Table
 //The input for any PTR_START_OF macro must be the ".c" filename of the user program
@@ -179,6 +188,7 @@ struct UserProgramInfo userPrograms[] = {
 		{ "ef_ms1", "", PTR_START_OF(ef_mergesort_noleakage)},
 		{ "ef_ms2", "", PTR_START_OF(ef_mergesort_leakage)},
 		{ "tef2", "", PTR_START_OF(tst_envfree2)},
+		{ "twait", "tests running, exiting & reaping several envs (sys_waitenv)", PTR_START_OF(tst_waitenv)},
 
 		//[1] READY MADE TESTS
 		{ "tbf1", "tests best fit (1): always find suitable space", PTR_START_OF(tst_best_fit_1)},
@@ -204,6 +214,9 @@ struct UserProgramInfo* ptr_UserPrograms = &userPrograms[0];
 // Number of user programs in the program table
 int NUM_USER_PROGS = (sizeof(userPrograms)/sizeof(userPrograms[0]));
 
+//2026: the programs of the program store missing from the table (filled on their first lookup)
+struct UserProgramInfo storePrograms[PS_MAX_PROGRAMS];
+
 //
 // Allocates and initializes a new environment.
 // On success, the new environment is stored in *e.
@@ -247,10 +260,9 @@ void * create_user_directory()
 	return ptr_user_page_directory;
 }
 
-void ShareWSAtUserSpace(struct Env* e)
+//2026: map the page WS of the given env at USER_PAGES_WS_START (read only)
+static void MapWSAtUserSpace(struct Env* e)
 {
-	e->__uptr_pws = (struct WorkingSetElement*) USER_PAGES_WS_START;
-	e->ptr_pageWorkingSet = create_user_page_WS(e->page_WS_max_size);
 	unsigned int sva = (unsigned int) e->ptr_pageWorkingSet;
 	uint32 nBytes = sizeof(struct WorkingSetElement) * e->page_WS_max_size;
 	unsigned int dva = (unsigned int) (e->__uptr_pws);
@@ -269,6 +281,132 @@ void ShareWSAtUserSpace(struct Env* e)
 	}
 }
 
+void ShareWSAtUserSpace(struct Env* e)
+{
+	e->__uptr_pws = (struct WorkingSetElement*) USER_PAGES_WS_START;
+	e->ptr_pageWorkingSet = create_user_page_WS(e->page_WS_max_size);
+	MapWSAtUserSpace(e);
+}
+
+//2026: replace the page WS of the given env by a new one of the given size (at least its # pages).
+//Its pages are moved to the start of the new one from the oldest (at page_last_WS_index) to the newest.
+//Returns E_NO_MEM if there's no kernel heap space for the new WS (then it's unchanged)
+static int ResizeWS(struct Env* e, uint32 newSize)
+{
+	struct WorkingSetElement* oldWS = e->ptr_pageWorkingSet;
+	uint32 oldSize = e->page_WS_max_size;
+	struct WorkingSetElement* newWS = create_user_page_WS(newSize);
+	uint32 i, n = 0;
+
+	if (newWS == NULL)
+		return E_NO_MEM;
+	for (i = 0; i < oldSize; i++)
+	{
+		struct WorkingSetElement* element = &(oldWS[(e->page_last_WS_index + i) % oldSize]);
+		if (!element->empty)
+			newWS[n++] = *element;
+	}
+	assert(n <= newSize);
+	for (i = n; i < newSize; i++)
+	{
+		newWS[i].virtual_address = 0;
+		newWS[i].empty = 1;
+		newWS[i].time_stamp = 0;
+	}
+
+	//unmap the old one from the user space
+	uint32 dva;
+	for (dva = USER_PAGES_WS_START; dva < USER_PAGES_WS_START + sizeof(struct WorkingSetElement) * oldSize; dva += PAGE_SIZE)
+	{
+		uint32* ptr_page_table;
+		if (get_page_table(e->env_page_directory, (void*) dva, &ptr_page_table) != TABLE_NOT_EXIST)
+			ptr_page_table[PTX(dva)] = 0;
+	}
+	kfree(oldWS);
+
+	e->ptr_pageWorkingSet = newWS;
+	e->page_WS_max_size = newSize;
+	e->page_last_WS_index = n % newSize;
+	MapWSAtUserSpace(e);
+	if (rcr3() == e->env_cr3)
+		tlbflush();
+	return 0;
+}
+
+//2026: remove the given # pages from the page WS of the given env (the victims of the replacement:
+//the least recently used with the LRU, else the oldest ones). The pages pinned by mlock stay.
+//Returns the # pages removed
+static uint32 RemoveWSVictims(struct Env* e, uint32 count)
+{
+	uint32 removed = 0;
+	//pf_update_env_page() temporarily maps the frame in the env's directory, so switch to it
+	uint32 old_cr3 = rcr3();
+	lcr3(e->env_cr3);
+
+	for (; removed < count; removed++)
+	{
+		int victim = -1;
+		for (uint32 j = 0; j < e->page_WS_max_size; j++)
+		{
+			uint32 i = (e->page_last_WS_index + j) % e->page_WS_max_size;
+			if (env_page_ws_is_entry_empty(e, i) || (pt_get_page_permissions(e, env_page_ws_get_virtual_address(e, i)) & PERM_LOCKED))
+				continue;
+			if (victim < 0 || (isPageReplacmentAlgorithmLRU() && env_page_ws_get_time_stamp(e, i) < env_page_ws_get_time_stamp(e, victim)))
+				victim = i;
+			if (!isPageReplacmentAlgorithmLRU())
+				break;
+		}
+		if (victim < 0)
+			break;
+
+		uint32 va = env_page_ws_get_virtual_address(e, victim);
+		uint32 *ptr_page_table = NULL;
+		struct Frame_Info* ptr_frame_info = get_frame_info(e->env_page_directory, (void*)va, &ptr_page_table);
+		if (ptr_frame_info != NULL)
+		{
+			if (pt_get_page_permissions(e, va) & PERM_MODIFIED)
+			{
+				pf_update_env_page(e, (void*)va, ptr_frame_info);
+			}
+			unmap_frame(e->env_page_directory, (void*)va);
+		}
+		env_page_ws_clear_entry(e, victim);
+	}
+
+	lcr3(old_cr3);
+	return removed;
+}
+
+//2026: double the page WS of the given env if it's full (only if it was never doubled if isOneTimeOnly)
+void double_WS_Size(struct Env* e, int isOneTimeOnly)
+{
+	if (isOneTimeOnly && e->isWSDoubled)
+		return;
+	if (env_page_ws_get_size(e) < e->page_WS_max_size)
+		return;
+	if (ResizeWS(e, 2 * e->page_WS_max_size) == 0)
+		e->isWSDoubled = 1;
+}
+
+//2026: halve the page WS of the given env (at least 1 page): if isImmidiate, its extra pages are
+//removed (see RemoveWSVictims()), else it's halved only if its pages fit in the half
+void half_WS_Size(struct Env* e, int isImmidiate)
+{
+	uint32 newSize = MAX(e->page_WS_max_size / 2, 1);
+	uint32 size = env_page_ws_get_size(e);
+	if (newSize == e->page_WS_max_size)
+		return;
+	if (size > newSize)
+	{
+		if (!isImmidiate)
+			return;
+		//(the locked pages stay, so it may not shrink that much)
+		size -= RemoveWSVictims(e, size - newSize);
+		newSize = MAX(newSize, size);
+	}
+	ResizeWS(e, newSize);
+}
+
 //
 // Initialize the kernel virtual memory layout for environment e.
 // Given a pointer to an allocated page directory, set the e->env_pgdir and e->env_cr3 accordingly,
@@ -339,6 +477,26 @@ void initialize_environment(struct Env* e, uint32* ptr_user_page_directory
 
 	e->nClocks = 0;
 
+	e->priority = PRIORITY_NORMAL;
+	e->nSuspensions = 0;
+	e->suspendedWSSize = 0;
+
+	e->ptr_profile = NULL;
+
+	memset(e->memAdvices, 0, sizeof(e->memAdvices));
+	e->nLockedPages = 0;
+
+	e->pendingPageInVA = 0;
+
+	e->nLazySegments = 0;
+	e->ptr_shared_image = NULL;
+
+	e->runTime = e->waitTime = e->maxWaitTime = 0;
+	e->nSwitches = 0;
+	e->isWSDoubled = 0;
+	e->exitStatus = 0;
+	e->dlRuntime = e->dlPeriod = 0;
+	e->dlPeriods = e->dlMissed = e->dlThrottles = 0;
 
 	//Completes other environment initializations, (envID, status and most of registers)
 	complete_environment_initialization(e);
@@ -445,6 +603,8 @@ struct Env* env_create(char* user_program_name, unsigned int page_WS_size, unsig
 
 	struct UserProgramInfo* ptr_user_program_info = get_user_program_info(user_program_name);
 	if(ptr_user_program_info == 0) return NULL;
+	//2026: read its image from the program store (if it's not linked in the kernel)
+	if(env_program_image_attach(ptr_user_program_info) != 0) return NULL;
 	ptr_program_start = ptr_user_program_info->ptr_start ;
 
 
@@ -454,6 +614,7 @@ struct Env* env_create(char* user_program_name, unsigned int page_WS_size, unsig
 	struct Env* e = NULL;
 	if(allocate_environment(&e) < 0)
 	{
+		env_program_image_detach(ptr_user_program_info);
 		return 0;
 	}
 
@@ -515,8 +676,19 @@ struct Env* env_create(char* user_program_name, unsigned int page_WS_size, unsig
 	uint32 remaining_ws_pages = (e->page_WS_max_size)-1; // we are reserving 1 page of WS for the stack that will be allocated just before the end of this function
 	uint32 lastTableNumber=0xffffffff;
 
+	//[6.5] 2026: with lazy loading, only record the segments (a program with more than
+	//			  MAX_LAZY_SEGMENTS segments is loaded below as usual)
+	if (isLazyLoadingEnabled())
+	{
+		env_lazy_record_segments(e, ptr_program_start);
+		if (e->nLazySegments > 0 && isSharedTextEnabled())
+			env_shared_image_attach(e, ptr_user_program_info);
+	}
+
 	PROGRAM_SEGMENT_FOREACH(seg, ptr_program_start)
 	{
+		if (e->nLazySegments > 0)
+			break;
 		segment_counter++;
 		//allocate space for current program segment and map it at seg->virtual_address then copy its content
 		// from seg->ptr_start to seg->virtual_address
@@ -632,7 +804,8 @@ struct Env* env_create(char* user_program_name, unsigned int page_WS_size, unsig
 	uint32 ptr_user_stack_bottom = (USTACKTOP - 1*PAGE_SIZE);
 
 	uint32 stackVa = USTACKTOP - PAGE_SIZE;
-	for(;stackVa >= ptr_user_stack_bottom; stackVa -= PAGE_SIZE)
+	//2026: (the stack of a lazily loaded program is zeroed on its first fault)
+	for(;e->nLazySegments == 0 && stackVa >= ptr_user_stack_bottom; stackVa -= PAGE_SIZE)
 	{
 		struct Frame_Info *pp = NULL;
 		allocate_frame(&pp);
@@ -663,6 +836,13 @@ struct Env* env_create(char* user_program_name, unsigned int page_WS_size, unsig
 	//	cprintf("Page working set after loading the program...\n");
 	//	env_page_ws_print(e);
 
+	//[9.5] 2026: prewarm the WS from the recorded fault profile of this program (if any),
+	//			  otherwise start recording one
+	if (isWSProfilingEnabled())
+	{
+		env_ws_profile_start(e, ptr_user_program_info);
+	}
+
 	///[10] switch back to the page directory exists before segment loading
 	lcr3(kern_phys_pgdir) ;
 
@@ -682,8 +862,11 @@ void env_run(struct Env *e)
 	{
 		curenv = e ;
 		curenv->env_runs++ ;
+		curenv->nSwitches++ ;
 		lcr3(curenv->env_cr3) ;
 	}
+	//2026: CPU accounting (the end of its wait in the ready queue)
+	sched_account_resume(curenv);
 	curenv->env_status = ENV_RUNNABLE;
 	//uint16 cnt0 = kclock_read_cnt0();
 	//cprintf("env_run %s [%d]: Cnt BEFORE RESUME = %d\n", curenv->prog_name,curenv->env_id, cnt0);
@@ -708,6 +891,13 @@ void env_free(struct Env *e);
 
 void start_env_free(struct Env *e)
 {
+	//2026: drop its pending page-in (if any)
+	pf_async_cancel(e);
+	//2026: release its CPU utilization (if it's a deadline env)
+	sched_clear_deadline(e);
+	//2026: its parent may be waiting for it
+	sched_wake_parent(e);
+
 	if(isBufferingEnabled())
 	{
 		__env_free_with_buffering(e);
@@ -733,6 +923,16 @@ void env_free(struct Env *e)
 
 	//YOUR CODE ENDS HERE --------------------------------------------
 
+	//2026: keep the fault profile of a short-lived env
+	if (e->ptr_profile != NULL)
+	{
+		env_ws_profile_save(e);
+	}
+
+	//2026: release its use of the shared text of the program
+	env_shared_image_detach(e);
+	env_program_image_detach(get_user_program_info_by_env(e));
+
 	//Don't change these lines:
 	pf_free_env(e); /*(ALREADY DONE for you)*/ // (removes all of the program pages from the page file)
 	free_environment(e); /*(ALREADY DONE for you)*/ // (frees the environment (returns it back to the free environment list))
@@ -841,6 +1041,7 @@ struct ProgramSegment* PROGRAM_SEGMENT_NEXT(struct ProgramSegment* seg, uint8* p
 		(*seg).size_in_memory =  ph[index].p_memsz;
 		(*seg).size_in_file = ph[index].p_filesz;
 		(*seg).virtual_address = (uint8*)ph[index].p_va;
+		(*seg).flags = ph[index].p_flags;
 		return seg;
 	}
 	return 0;
@@ -865,12 +1066,39 @@ struct ProgramSegment PROGRAM_SEGMENT_FIRST( uint8* ptr_program_start)
 		(seg).size_in_memory =  ph[index].p_memsz;
 		(seg).size_in_file = ph[index].p_filesz;
 		(seg).virtual_address = (uint8*)ph[index].p_va;
+		(seg).flags = ph[index].p_flags;
 		return seg;
 	}
 	seg.segment_id = -1;
 	return seg;
 }
 
+//2026: returns the info of the given program of the program store (NULL if not found)
+static struct UserProgramInfo* get_store_program_info(char* user_program_name)
+{
+	struct ProgramStoreEntry* entry = ps_find(user_program_name);
+	if (entry == NULL)
+		return NULL;
+
+	struct UserProgramInfo* ptr_store_program = &storePrograms[entry - ps_get(0)];
+	if (ptr_store_program->name == NULL)
+	{
+		ptr_store_program->name = entry->name;
+		ptr_store_program->desc = "From the program store";
+		ptr_store_program->store_name = entry->name;
+		ptr_store_program->ptr_store_entry = entry;
+	}
+	return ptr_store_program;
+}
+
+//2026: index of the given program: in the table, then in the program store
+uint32 get_user_program_index(struct UserProgramInfo* ptr_user_program_info)
+{
+	if (ptr_user_program_info >= userPrograms && ptr_user_program_info < userPrograms + NUM_USER_PROGS)
+		return ptr_user_program_info - userPrograms;
+	return NUM_USER_PROGS + (ptr_user_program_info - storePrograms);
+}
+
 struct UserProgramInfo* get_user_program_info(char* user_program_name)
 {
 	int i;
@@ -880,6 +1108,10 @@ struct UserProgramInfo* get_user_program_info(char* user_program_name)
 	}
 	if(i==NUM_USER_PROGS)
 	{
+		//2026: not in the table: look it up in the program store
+		struct UserProgramInfo* ptr_store_program = get_store_program_info(user_program_name);
+		if (ptr_store_program != NULL)
+			return ptr_store_program;
 		cprintf("Unknown user program '%s'\n", user_program_name);
 		return 0;
 	}
@@ -896,6 +1128,10 @@ struct UserProgramInfo* get_user_program_info_by_env(struct Env* e)
 	}
 	if(i==NUM_USER_PROGS)
 	{
+		//2026: not in the table: look it up in the program store
+		struct UserProgramInfo* ptr_store_program = get_store_program_info(e->prog_name);
+		if (ptr_store_program != NULL)
+			return ptr_store_program;
 		cprintf("Unknown user program \n");
 		return 0;
 	}
@@ -914,6 +1150,85 @@ void set_environment_entry_point(struct Env* e, uint8* ptr_program_start)
 
 
 
+//==================================================================================//
+//============================== 2026: WS PREWARMING ===============================//
+//==================================================================================//
+
+uint32 _EnableWSProfiling ;
+void enableWSProfiling(uint32 enableIt){_EnableWSProfiling = enableIt;}
+uint32 isWSProfilingEnabled(){ return _EnableWSProfiling; }
+
+void env_ws_profile_start(struct Env* e, struct UserProgramInfo* ptr_user_program_info)
+{
+	uint32 index = get_user_program_index(ptr_user_program_info);
+	struct ProgramProfile* profile = kmalloc(sizeof(struct ProgramProfile));
+	if (profile == NULL)
+		return;
+
+	if (pf_read_program_profile(index, profile) == 0 && profile->magic == PF_PROFILE_MAGIC
+			&& profile->count <= PF_PROFILE_MAX_PAGES
+			&& strncmp(profile->prog_name, e->prog_name, PROGNAMELEN) == 0)
+	{
+		env_page_ws_prefetch(e, profile->va, profile->count);
+		kfree(profile);
+	}
+	else
+	{
+		//No valid profile: record one during the first WS_PROFILE_RECORD_TICKS of the env
+		memset(profile, 0, sizeof(struct ProgramProfile));
+		profile->magic = PF_PROFILE_MAGIC;
+		strncpy(profile->prog_name, e->prog_name, PROGNAMELEN);
+		e->ptr_profile = profile;
+	}
+}
+
+void env_ws_profile_record(struct Env* e, uint32 fault_va)
+{
+	struct ProgramProfile* profile = e->ptr_profile;
+	uint32 va = ROUNDDOWN(fault_va, PAGE_SIZE);
+	int i;
+
+	if (profile == NULL || profile->count == PF_PROFILE_MAX_PAGES)
+		return;
+	for (i = 0; i < profile->count; i++)
+	{
+		if (profile->va[i] == va)
+			return;
+	}
+	profile->va[profile->count++] = va;
+}
+
+//Stops the recording and writes the profile (if any page was recorded) to the page file
+void env_ws_profile_save(struct Env* e)
+{
+	struct ProgramProfile* profile = e->ptr_profile;
+	if (profile == NULL)
+		return;
+
+	e->ptr_profile = NULL;
+	struct UserProgramInfo* ptr_user_program_info = get_user_program_info_by_env(e);
+	if (ptr_user_program_info != NULL && profile->count > 0)
+	{
+		pf_write_program_profile(get_user_program_index(ptr_user_program_info), profile);
+	}
+	kfree(profile);
+}
+
+int env_ws_profile_clear(char* user_program_name)
+{
+	struct UserProgramInfo* ptr_user_program_info = get_user_program_info(user_program_name);
+	if (ptr_user_program_info == NULL)
+		return E_INVAL;
+
+	struct ProgramProfile* profile = kmalloc(sizeof(struct ProgramProfile));
+	if (profile == NULL)
+		return E_NO_MEM;
+	memset(profile, 0, sizeof(struct ProgramProfile));
+	int ret = pf_write_program_profile(get_user_program_index(ptr_user_program_info), profile);
+	kfree(profile);
+	return ret;
+}
+
 //it add the "curenv" to the EXIT list, then reinvoke the scheduler
 void env_exit()
 {
@@ -995,3 +1310,248 @@ env_pop_tf(struct Trapframe *tf)
 	panic("iret failed");  /* mostly to placate the compiler */
 }
 
+
+//==================================================================================//
+//=========================== 2026: LAZY PROGRAM LOADING ===========================//
+//==================================================================================//
+
+uint32 _EnableLazyLoading ;
+void enableLazyLoading(uint32 enableIt){_EnableLazyLoading = enableIt;}
+uint32 isLazyLoadingEnabled(){ return _EnableLazyLoading; }
+
+//Records the segments of the program in "e". Returns E_NO_MEM (and records nothing) if there are
+//more than MAX_LAZY_SEGMENTS
+static int env_lazy_record_segments(struct Env* e, uint8* ptr_program_start)
+{
+	struct ProgramSegment* seg = NULL;
+	e->nLazySegments = 0;
+	PROGRAM_SEGMENT_FOREACH(seg, ptr_program_start)
+	{
+		if (e->nLazySegments == MAX_LAZY_SEGMENTS)
+		{
+			e->nLazySegments = 0;
+			return E_NO_MEM;
+		}
+		struct LazySegment* ls = &(e->lazySegments[e->nLazySegments++]);
+		ls->start = (uint32)seg->virtual_address;
+		ls->fileEnd = ls->start + seg->size_in_file;
+		ls->memEnd = ls->start + seg->size_in_memory;
+		ls->src = seg->ptr_start;
+		ls->readOnly = ((seg->flags & ELF_PROG_FLAG_WRITE) == 0);
+	}
+	return 0;
+}
+
+//Returns 1 if "e" is lazily loaded and the given page belongs to one of its segments or to the stack
+uint32 env_page_is_lazy(struct Env* e, uint32 virtual_address)
+{
+	int i;
+	if (e->nLazySegments == 0)
+		return 0;
+	if (virtual_address < USTACKTOP && virtual_address >= USTACKBOTTOM)
+		return 1;
+	for (i = 0; i < e->nLazySegments; i++)
+	{
+		struct LazySegment* ls = &(e->lazySegments[i]);
+		if (virtual_address >= ROUNDDOWN(ls->start, PAGE_SIZE) && virtual_address < ROUNDUP(ls->memEnd, PAGE_SIZE))
+			return 1;
+	}
+	return 0;
+}
+
+//Fills the given page (already mapped in the directory of "e", which should be loaded) that is not in
+//the page file: copies its parts of the segments from the program image and zeros the rest.
+//Returns E_PAGE_NOT_EXIST_IN_PF if it's not a lazily loaded page
+int env_page_lazy_fill(struct Env* e, uint32 virtual_address)
+{
+	uint32 va = ROUNDDOWN(virtual_address, PAGE_SIZE);
+	int i;
+
+	if (!env_page_is_lazy(e, va))
+		return E_PAGE_NOT_EXIST_IN_PF;
+
+	memset((void*)va, 0, PAGE_SIZE);
+	for (i = 0; i < e->nLazySegments; i++)
+	{
+		struct LazySegment* ls = &(e->lazySegments[i]);
+		uint32 from = MAX(va, ls->start);
+		uint32 to = MIN(va + PAGE_SIZE, ls->fileEnd);
+		if (from < to)
+			memcpy((void*)from, ls->src + (from - ls->start), to - from);
+	}
+
+	//as pf_read_env_page(): the page is still clean, it can be dropped and filled again
+	pt_set_page_permissions(e, va, 0, PERM_MODIFIED);
+	return 0;
+}
+
+
+//==================================================================================//
+//============================ 2026: SHARED PROGRAM TEXT ===========================//
+//==================================================================================//
+
+uint32 _EnableSharedText ;
+void enableSharedText(uint32 enableIt){_EnableSharedText = enableIt;}
+uint32 isSharedTextEnabled(){ return _EnableSharedText; }
+
+//Attaches "e" to the shared image of its program (creating it on its first instance)
+static void env_shared_image_attach(struct Env* e, struct UserProgramInfo* ptr_user_program_info)
+{
+	struct SharedImage* img = ptr_user_program_info->ptr_shared_image;
+	if (img == NULL)
+	{
+		uint32 start = 0xFFFFFFFF, end = 0;
+		int i;
+		for (i = 0; i < e->nLazySegments; i++)
+		{
+			struct LazySegment* ls = &(e->lazySegments[i]);
+			if (!ls->readOnly)
+				continue;
+			start = MIN(start, ROUNDDOWN(ls->start, PAGE_SIZE));
+			end = MAX(end, ROUNDUP(ls->memEnd, PAGE_SIZE));
+		}
+		if (start >= end)
+			return;
+
+		img = kmalloc(sizeof(struct SharedImage));
+		if (img == NULL)
+			return;
+		img->nPages = (end - start) / PAGE_SIZE;
+		img->frames = kmalloc(img->nPages * sizeof(struct Frame_Info*));
+		if (img->frames == NULL)
+		{
+			kfree(img);
+			return;
+		}
+		memset(img->frames, 0, img->nPages * sizeof(struct Frame_Info*));
+		img->start = start;
+		img->nInstances = 0;
+		img->ptr_program = ptr_user_program_info;
+		ptr_user_program_info->ptr_shared_image = img;
+	}
+	img->nInstances++;
+	e->ptr_shared_image = img;
+}
+
+//Detaches "e" from its shared image: the image (and its references on the frames) is freed with
+//the last instance
+static void env_shared_image_detach(struct Env* e)
+{
+	struct SharedImage* img = e->ptr_shared_image;
+	int i;
+	if (img == NULL)
+		return;
+
+	e->ptr_shared_image = NULL;
+	if (--(img->nInstances) > 0)
+		return;
+
+	img->ptr_program->ptr_shared_image = NULL;
+	for (i = 0; i < img->nPages; i++)
+	{
+		if (img->frames[i] != NULL)
+			decrement_references(img->frames[i]);
+	}
+	kfree(img->frames);
+	kfree(img);
+}
+
+//Returns 1 if the given page of "e" is in a shared frame: a page of a read-only segment of its
+//program that doesn't overlap a writable one
+uint32 env_page_is_shared(struct Env* e, uint32 virtual_address)
+{
+	uint32 va = ROUNDDOWN(virtual_address, PAGE_SIZE);
+	uint8 readOnly = 0;
+	int i;
+
+	if (e->ptr_shared_image == NULL)
+		return 0;
+	for (i = 0; i < e->nLazySegments; i++)
+	{
+		struct LazySegment* ls = &(e->lazySegments[i]);
+		if (va + PAGE_SIZE <= ls->start || va >= ls->memEnd)
+			continue;
+		if (!ls->readOnly)
+			return 0;
+		readOnly = 1;
+	}
+	return readOnly;
+}
+
+//Maps the shared frame of the given page read-only in "e" (whose directory should be loaded),
+//loading it from the program image on the first fault of all the instances.
+//Returns E_PAGE_NOT_EXIST_IN_PF if the page isn't shared, E_NO_MEM if its frame can't be allocated
+int env_page_map_shared(struct Env* e, uint32 virtual_address)
+{
+	struct SharedImage* img = e->ptr_shared_image;
+	uint32 va = ROUNDDOWN(virtual_address, PAGE_SIZE);
+
+	if (!env_page_is_shared(e, va))
+		return E_PAGE_NOT_EXIST_IN_PF;
+
+	struct Frame_Info** ptr_frame = &(img->frames[(va - img->start) / PAGE_SIZE]);
+	if (*ptr_frame != NULL)
+	{
+		map_frame(e->env_page_directory, *ptr_frame, (void*)va, PERM_USER);
+		return 0;
+	}
+
+	//first fault: fill it through a writable mapping, then write-protect it
+	struct Frame_Info* ptr_frame_info = NULL;
+	if (allocate_frame(&ptr_frame_info) == E_NO_MEM)
+		return E_NO_MEM;
+	map_frame(e->env_page_directory, ptr_frame_info, (void*)va, PERM_USER | PERM_WRITEABLE);
+	env_page_lazy_fill(e, va);
+	pt_set_page_permissions(e, va, 0, PERM_WRITEABLE);
+
+	ptr_frame_info->references++;	//the image's reference
+	*ptr_frame = ptr_frame_info;
+	return 0;
+}
+
+
+//==================================================================================//
+//============================== 2026: PROGRAM STORE ===============================//
+//==================================================================================//
+
+//Makes sure the image of the given program is in memory for a new env of it: reads it from the
+//program store on its first env (if it's not linked in the kernel)
+static int env_program_image_attach(struct UserProgramInfo* ptr_user_program_info)
+{
+	if (ptr_user_program_info->ptr_store_entry == NULL)
+	{
+		if (ptr_user_program_info->ptr_start != NULL)
+			return 0;
+		ptr_user_program_info->ptr_store_entry = ps_find(ptr_user_program_info->store_name);
+		if (ptr_user_program_info->ptr_store_entry == NULL)
+		{
+			cprintf("%s is not in the program store\n", ptr_user_program_info->name);
+			return E_INVAL;
+		}
+	}
+	if (ptr_user_program_info->nImageUsers == 0)
+	{
+		ptr_user_program_info->ptr_start = ps_read_image(ptr_user_program_info->ptr_store_entry);
+		if (ptr_user_program_info->ptr_start == NULL)
+		{
+			cprintf("Can't read the image of %s from the program store\n", ptr_user_program_info->name);
+			return E_NO_MEM;
+		}
+	}
+	ptr_user_program_info->nImageUsers++;
+	return 0;
+}
+
+//Releases the use of the image of the given program by an env: an image read from the program
+//store is freed with its last env
+static void env_program_image_detach(struct UserProgramInfo* ptr_user_program_info)
+{
+	if (ptr_user_program_info == NULL || ptr_user_program_info->ptr_store_entry == NULL
+			|| ptr_user_program_info->nImageUsers == 0)
+		return;
+	if (--(ptr_user_program_info->nImageUsers) == 0)
+	{
+		kfree(ptr_user_program_info->ptr_start);
+		ptr_user_program_info->ptr_start = NULL;
+	}
+}
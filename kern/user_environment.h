@@ -14,15 +14,40 @@
 #define DECLARE_START_OF(binary_name)  \
 	extern uint8 _binary_obj_user_##binary_name##_start[];
 
+//2026: also sets the remaining fields of the UserProgramInfo: its name in the program store (the
+//		".c" filename). With FOS_PROGRAM_STORE (make PROGSTORE=1), the programs aren't linked in the
+//		kernel: their image is read from the program store (see kern/program_store.h)
+#ifndef FOS_PROGRAM_STORE
 #define PTR_START_OF(binary_name) ( \
 	(uint8*) _binary_obj_user_##binary_name##_start \
-	)
+	), NULL, #binary_name
+#else
+#define PTR_START_OF(binary_name) NULL, NULL, #binary_name
+#endif
 
 //=========================================================
 struct UserProgramInfo {
 	const char *name;
 	const char *desc;
 	uint8* ptr_start;
+	struct SharedImage* ptr_shared_image;	//2026: shared text of its running instances (NULL if none)
+
+	//2026: program store
+	const char *store_name;						// name of its image in the program store
+	struct ProgramStoreEntry* ptr_store_entry;	// its image in the store (NULL if linked in the kernel)
+	uint32 nImageUsers;							// # envs using its image read from the store (freed with the last one)
+};
+
+//2026: frames of the read-only pages of a program, shared between its lazily loaded instances.
+//Each frame is loaded on the first fault of any instance and mapped read-only in every instance
+//that faults on it: its references are the instances mapping it + 1 for the image itself.
+//They're never modified, so never written to the page file.
+struct SharedImage {
+	uint32 nInstances;				// # instances using the image (it's freed with the last one)
+	uint32 start;					// va of its first page
+	uint32 nPages;
+	struct Frame_Info** frames;		// frame of each page (NULL if not loaded yet)
+	struct UserProgramInfo* ptr_program;	// its program (in userPrograms[] or storePrograms[])
 };
 
 //========================================================
@@ -39,6 +64,7 @@ extern struct Env *curenv;	        // Current environment
 
 struct UserProgramInfo*  get_user_program_info(char* user_program_name);
 struct UserProgramInfo* get_user_program_info_by_env(struct Env* e);
+uint32 get_user_program_index(struct UserProgramInfo* ptr_user_program_info);
 //2016
 struct Env* env_create(char* user_program_name, unsigned int page_WS_size, unsigned int percent_WS_pages_to_remove);
 void	start_env_free(struct Env *e);
@@ -46,6 +72,28 @@ void	start_env_free(struct Env *e);
 //2015
 void env_exit();
 
+//2026: WS prewarming from the recorded per-program fault profiles
+#define WS_PROFILE_RECORD_TICKS 10		//record the faults of the first 10 clock ticks of the env (~100 ms)
+void enableWSProfiling(uint32 enableIt);
+uint32 isWSProfilingEnabled();
+void env_ws_profile_record(struct Env* e, uint32 fault_va);
+void env_ws_profile_save(struct Env* e);
+int env_ws_profile_clear(char* user_program_name);
+
+//2026: lazy program loading: env_create only records the program segments, each page is filled
+//from the program image (or by zeros for the bss and the stack) on its first fault, and gets a
+//page file slot only when first written back
+void enableLazyLoading(uint32 enableIt);
+uint32 isLazyLoadingEnabled();
+uint32 env_page_is_lazy(struct Env* e, uint32 virtual_address);
+int env_page_lazy_fill(struct Env* e, uint32 virtual_address);
+
+//2026: shared program text (of the lazily loaded programs only)
+void enableSharedText(uint32 enableIt);
+uint32 isSharedTextEnabled();
+uint32 env_page_is_shared(struct Env* e, uint32 virtual_address);
+int env_page_map_shared(struct Env* e, uint32 virtual_address);
+
 
 // working set functions
 
@@ -28,18 +28,12 @@ void schenv()
 	}
 	if (curenv != NULL)
 	{
-		if (__ne != NULL)
-		{
-			if ((__pl + 1) < __nl)
-			{
-				__ne = curenv;
-				__nl = __pl < num_of_ready_queues-1? __pl + 1 : __pl ;
-			}
-		}
-		else
+		//2026: the curenv is demoted only if it has used its full quantum
+		__tl = (sched_quantum_expired && __pl < num_of_ready_queues-1) ? __pl + 1 : __pl ;
+		if (__ne == NULL || __tl < __nl)
 		{
 			__ne = curenv;
-			__nl = __pl < num_of_ready_queues-1? __pl + 1 : __pl ;
+			__nl = __tl;
 		}
 	}
 }
@@ -54,20 +48,18 @@ void chksch(uint8 onoff)
 }
 void chk1()
 {
-	if (__chkstatus == 0)
+	//2026: (the RR & MLFQ only, without deadline envs)
+	if (__chkstatus == 0 || isSchedMethodCFS() || edf_total_utilization > 0)
 		return ;
 	__pe = curenv;
-	__pl = __nl ;
-	if (__pe == NULL)
-	{
-		__pl = 0;
-	}
+	//2026: (the level is kept in the env)
+	__pl = (__pe == NULL) ? 0 : __pe->schedLevel ;
 	//cprintf("chk1: current = %s @ level %d\n", __pe == NULL? "NULL" : __pe->prog_name, __pl);
 	schenv();
 }
 void chk2(struct Env* __se)
 {
-	if (__chkstatus == 0)
+	if (__chkstatus == 0 || isSchedMethodCFS() || edf_total_utilization > 0)
 		return ;
 
 	//cprintf("chk2: next = %s @ level %d\n", __ne == NULL? "NULL" : __ne->prog_name, __nl);
@@ -77,9 +69,10 @@ void chk2(struct Env* __se)
 
 	if (__ne != NULL)
 	{
-		uint16 upper = TIMER_DIV((1000/quantums[__nl])) ;
-		uint16 lower = 90 * upper / 100 ;
-		uint16 current = kclock_read_cnt0_latch();
+		//2026: (the 8253 or the local APIC timer)
+		uint32 upper = sched_quantum_us(__ne, __nl) ;
+		uint32 lower = 90 * upper / 100 ;
+		uint32 current = kclock_remaining_us();
 		//cprintf("current = %d, lower = %d, upper = %d\n", current, lower, upper);
 		assert_endall(current > lower && current <= upper) ;
 
@@ -90,7 +83,6 @@ void chk2(struct Env* __se)
 	}
 	if (__pe != NULL && __pe != __ne)
 	{
-		uint8 __tl = __pl == num_of_ready_queues-1 ? __pl : __pl + 1 ;
 		assert_endall(find_env_in_queue(&(env_ready_queues[__tl]), __pe->env_id) != NULL);
 		for (int i = 0; i < num_of_ready_queues; ++i)
 		{
@@ -11,7 +11,7 @@ void scarce_memory();
 uint32 calc_no_pages_tobe_removed_from_ready_exit_queues();
 
 struct Env *__pe, *__ne ;
-uint8 __pl, __nl, __chkstatus ;
+uint8 __pl, __nl, __tl, __chkstatus ;
 void chksch(uint8 onoff);
 void chk1();
 void chk2(struct Env* __se);
@@ -2,23 +2,48 @@
  * Minimal PIO-based (non-interrupt-driven) IDE driver code.
  * For information about what all this IDE/ATA magic means,
  * see the materials available on the class references page.
+ *
+ * 2026: if a PCI IDE controller with bus-master capability is found (e.g. QEMU's PIIX3),
+ * the transfers use DMA through a physically contiguous bounce buffer instead (see ide_dma_init()).
+ * PIO remains the fallback.
  */
 
 #include <inc/disk.h>
 #include <inc/x86.h>
+#include <inc/string.h>
+#include <inc/memlayout.h>
 
 #define IDE_BSY		0x80
 #define IDE_DRDY	0x40
 #define IDE_DF		0x20
+#define IDE_DRQ		0x08
 #define IDE_ERR		0x01
 
+#define IDE_CMD_READ			0x20
+#define IDE_CMD_WRITE			0x30
+#define IDE_CMD_READ_EXT		0x24
+#define IDE_CMD_WRITE_EXT		0x34
+#define IDE_CMD_READ_DMA		0xC8
+#define IDE_CMD_WRITE_DMA		0xCA
+#define IDE_CMD_READ_DMA_EXT	0x25
+#define IDE_CMD_WRITE_DMA_EXT	0x35
+#define IDE_CMD_IDENTIFY		0xEC
+
+//2026: I/O ports of the channel of the given disk (see IDE_CHANNEL())
+#define IDE_IOBASE(disk)	(IDE_CHANNEL(disk) == 0 ? 0x1F0 : 0x170)
+
 static int diskno = 0;
 
-static int ide_wait_ready(bool check_error)
+//2026: bus-master DMA state
+uint32 ide_dma_enabled;			//use DMA for the transfers (set by ide_dma_init(), can be turned off)
+static uint16 ide_bm_base;		//I/O base of the primary channel's bus-master registers (0 if none)
+uint32 ide_async_state;			//state of the asynchronous read (IDE_ASYNC_xxx)
+
+static int ide_wait_ready(uint16 iobase, bool check_error)
 {
 	int r;
 
-	while (((r = inb(0x1F7)) & (IDE_BSY|IDE_DRDY)) != IDE_DRDY)
+	while (((r = inb(iobase + 7)) & (IDE_BSY|IDE_DRDY)) != IDE_DRDY)
 		/* do nothing */;
 
 
@@ -30,59 +55,129 @@ static int ide_wait_ready(bool check_error)
 	return 0;
 }
 
+static int ide_dma_transfer(uint32 disk, uint32 secno, void *buf, uint32 nsecs, bool isWrite);
+
+//2026: disks supporting the 48-bit LBA commands (set by ide_identify())
+static uint8 ide_lba48[IDE_MAX_DISKS];
+
+//Max # sectors of a single command on the given disk
+uint32 ide_max_sectors(uint32 disk)
+{
+	return ide_lba48[disk] ? IDE_LBA48_MAX_SECTS : IDE_LBA28_MAX_SECTS;
+}
+
+//Issues a command to the given disk: 28-bit LBA, or 48-bit LBA (with the EXT version of the command)
+//if the sectors are beyond the first 128 GB or more than 256 of them are transferred
+static void ide_command(uint32 disk, uint32 secno, uint32 nsecs, uint8 cmd)
+{
+	uint16 iobase = IDE_IOBASE(disk);
+
+	if (ide_lba48[disk] && (secno + nsecs > IDE_LBA28_MAX_SECTOR || nsecs > IDE_LBA28_MAX_SECTS))
+	{
+		switch (cmd)
+		{
+		case IDE_CMD_READ:		cmd = IDE_CMD_READ_EXT; break;
+		case IDE_CMD_WRITE:		cmd = IDE_CMD_WRITE_EXT; break;
+		case IDE_CMD_READ_DMA:	cmd = IDE_CMD_READ_DMA_EXT; break;
+		case IDE_CMD_WRITE_DMA:	cmd = IDE_CMD_WRITE_DMA_EXT; break;
+		}
+		//high bytes first, then the low ones (65536 sectors is written as 0)
+		outb(iobase + 2, (nsecs >> 8) & 0xFF);
+		outb(iobase + 3, (secno >> 24) & 0xFF);
+		outb(iobase + 4, 0);
+		outb(iobase + 5, 0);
+		outb(iobase + 2, nsecs & 0xFF);
+		outb(iobase + 3, secno & 0xFF);
+		outb(iobase + 4, (secno >> 8) & 0xFF);
+		outb(iobase + 5, (secno >> 16) & 0xFF);
+		outb(iobase + 6, 0x40 | ((disk&1)<<4));
+		outb(iobase + 7, cmd);
+		return;
+	}
+
+	assert(secno + nsecs <= IDE_LBA28_MAX_SECTOR && nsecs <= IDE_LBA28_MAX_SECTS);
+	outb(iobase + 2, nsecs);
+	outb(iobase + 3, secno & 0xFF);
+	outb(iobase + 4, (secno >> 8) & 0xFF);
+	outb(iobase + 5, (secno >> 16) & 0xFF);
+	outb(iobase + 6, 0xE0 | ((disk&1)<<4) | ((secno>>24)&0x0F));
+	outb(iobase + 7, cmd);
+}
+
 int	ide_read(uint32 secno, void *dst, uint32 nsecs)
+{
+	return ide_read_disk(diskno, secno, dst, nsecs);
+}
+
+int ide_write(uint32 secno, const void *src, uint32 nsecs)
+{
+	return ide_write_disk(diskno, secno, src, nsecs);
+}
+
+int	ide_read_disk(uint32 disk, uint32 secno, void *dst, uint32 nsecs)
 {
 	int r;
+	uint16 iobase = IDE_IOBASE(disk);
 
-	assert(nsecs <= 256);
+	assert(nsecs <= ide_max_sectors(disk));
+
+	if (IDE_CHANNEL(disk) == 0)
+	{
+		//2026: the channel is shared with the asynchronous read (if any): let it finish first
+		if (ide_async_state == IDE_ASYNC_BUSY)
+			ide_async_poll(1);
+
+		if (ide_dma_enabled && ide_dma_transfer(disk, secno, dst, nsecs, 0) == 0)
+			return 0;
+	}
 
 	//TODOFUTUREWORK: This BUSY-WAIT should be replaced by Interrupt to allow the OS to schedule another process till the device become ready [el7 :)]
-	ide_wait_ready(0);
+	ide_wait_ready(iobase, 0);
 
-	outb(0x1F2, nsecs);
-	outb(0x1F3, secno & 0xFF);
-	outb(0x1F4, (secno >> 8) & 0xFF);
-	outb(0x1F5, (secno >> 16) & 0xFF);
-	outb(0x1F6, 0xE0 | ((diskno&1)<<4) | ((secno>>24)&0x0F));
-	outb(0x1F7, 0x20);	// CMD 0x20 means read sector
+	ide_command(disk, secno, nsecs, IDE_CMD_READ);
 
 	for (; nsecs > 0; nsecs--, dst += SECTSIZE) {
-		if ((r = ide_wait_ready(1)) < 0)
+		if ((r = ide_wait_ready(iobase, 1)) < 0)
 			return r;
-		insl(0x1F0, dst, SECTSIZE/4);
+		insl(iobase, dst, SECTSIZE/4);
 	}
 
 	return 0;
 }
 
-int ide_write(uint32 secno, const void *src, uint32 nsecs)
+int ide_write_disk(uint32 disk, uint32 secno, const void *src, uint32 nsecs)
 {
 	int r;
+	uint16 iobase = IDE_IOBASE(disk);
 
 	//LOG_STATMENT(cprintf("1 ==> nsecs = %d\n",nsecs);)
-	assert(nsecs <= 256);
+	assert(nsecs <= ide_max_sectors(disk));
+
+	if (IDE_CHANNEL(disk) == 0)
+	{
+		if (ide_async_state == IDE_ASYNC_BUSY)
+			ide_async_poll(1);
+
+		if (ide_dma_enabled && ide_dma_transfer(disk, secno, (void*)src, nsecs, 1) == 0)
+			return 0;
+	}
 
 	//LOG_STATMENT(cprintf("2\n");)
-	ide_wait_ready(0);
+	ide_wait_ready(iobase, 0);
 
 	//LOG_STATMENT(cprintf("3 ==> nsecs = %d\n",nsecs);)
-	outb(0x1F2, nsecs);
-	outb(0x1F3, secno & 0xFF);
-	outb(0x1F4, (secno >> 8) & 0xFF);
-	outb(0x1F5, (secno >> 16) & 0xFF);
-	outb(0x1F6, 0xE0 | ((diskno&1)<<4) | ((secno>>24)&0x0F));
-	outb(0x1F7, 0x30);	// CMD 0x30 means write sector
+	ide_command(disk, secno, nsecs, IDE_CMD_WRITE);
 
 
 	for (; nsecs > 0; nsecs--, src += SECTSIZE) {
-		if ((r = ide_wait_ready(1)) < 0)
+		if ((r = ide_wait_ready(iobase, 1)) < 0)
 		{
 			LOG_STATMENT(cprintf("FAILURE to write %d sectors to disk\n",nsecs););
 			return r;
 		}
 		else
 		{
-			outsl(0x1F0, src, SECTSIZE/4);
+			outsl(iobase, src, SECTSIZE/4);
 			//LOG_STATMENT(cprintf("written %d sectors to disk successfully\n",nsecs););
 		}
 	}
@@ -92,3 +187,411 @@ int ide_write(uint32 secno, const void *src, uint32 nsecs)
 	return 0;
 }
 
+//2026: Returns 1 if the given disk answers on its channel
+int ide_disk_present(uint32 disk)
+{
+	uint16 iobase = IDE_IOBASE(disk);
+	int r = 0, x;
+
+	//a channel without any drive floats the status to 0xFF
+	if (inb(iobase + 7) == 0xFF)
+		return 0;
+
+	outb(iobase + 6, 0xE0 | ((disk&1)<<4));
+	for (x = 0; x < 1000 && ((r = inb(iobase + 7)) & (IDE_BSY|IDE_DF|IDE_ERR)) != 0; x++)
+		/* do nothing */;
+
+	return (x < 1000 && (r & IDE_DRDY)) ? 1 : 0;
+}
+
+//2026: Reads the IDENTIFY data of the given disk: sets *nsectors to its capacity (capped to 2^32 - 1
+//sectors, the sector #s are 32-bit) and enables the 48-bit LBA commands if supported.
+//Returns 0, or -1 if the disk doesn't answer
+int ide_identify(uint32 disk, uint32* nsectors)
+{
+	uint16 iobase = IDE_IOBASE(disk);
+	uint16 id[256];
+	int r = 0, x;
+
+	if (!ide_disk_present(disk))
+		return -1;
+
+	outb(iobase + 6, 0xA0 | ((disk&1)<<4));
+	outb(iobase + 7, IDE_CMD_IDENTIFY);
+	for (x = 0; x < IDE_IDENTIFY_TIMEOUT && ((r = inb(iobase + 7)) & IDE_BSY); x++);
+	for (; x < IDE_IDENTIFY_TIMEOUT && (r & (IDE_DRQ|IDE_ERR)) == 0; x++)
+		r = inb(iobase + 7);
+	if (x == IDE_IDENTIFY_TIMEOUT || (r & IDE_ERR))
+		return -1;
+	insl(iobase, id, sizeof(id)/4);
+
+	//words 60-61: # sectors addressable by 28-bit LBA
+	*nsectors = id[60] | ((uint32)id[61] << 16);
+	//word 83 bit 10: 48-bit LBA supported, words 100-103: # sectors addressable by it
+	ide_lba48[disk] = (id[83] & (1 << 10)) ? 1 : 0;
+	if (ide_lba48[disk])
+	{
+		uint32 high = id[102] | ((uint32)id[103] << 16);
+		*nsectors = (high != 0) ? 0xFFFFFFFF : (id[100] | ((uint32)id[101] << 16));
+	}
+	return 0;
+}
+
+//==================================================================================//
+//============================ 2026: BUS-MASTER DMA ================================//
+//==================================================================================//
+
+//PCI configuration space
+#define PCI_CONFIG_ADDR		0xCF8
+#define PCI_CONFIG_DATA		0xCFC
+#define PCI_CLASS_STORAGE	0x01
+#define PCI_SUBCLASS_IDE	0x01
+#define PCI_IDE_PROGIF_BM	0x80	//controller is bus-master capable
+#define PCI_CMD_IO			0x01
+#define PCI_CMD_BUS_MASTER	0x04
+
+//Bus-master registers (offsets from BAR4, primary channel)
+#define BM_CMD				0
+#define   BM_CMD_START		0x01
+#define   BM_CMD_READ		0x08	//device -> memory
+#define BM_STATUS			2
+#define   BM_STATUS_ACTIVE	0x01
+#define   BM_STATUS_ERR		0x02
+#define   BM_STATUS_IRQ		0x04
+#define BM_PRDT				4
+
+
+#define IDE_DMA_TIMEOUT			10000000
+
+//Physical Region Descriptor
+struct PRD
+{
+	uint32 physical_address;
+	uint16 byte_count;		//0 means 64 KB
+	uint16 flags;			//bit 15: end of table
+};
+#define PRD_EOT 0x8000
+
+//All live in the kernel image (statically mapped at KERNEL_BASE), so they are physically contiguous.
+//The asynchronous read has its own buffer so that synchronous transfers can run before its data is collected
+static struct PRD ide_prd_table[1] __attribute__((aligned(8)));
+static uint8 ide_dma_bounce[IDE_DMA_BOUNCE_SECTS * SECTSIZE] __attribute__((aligned(65536)));
+static struct PRD ide_async_prd_table[1] __attribute__((aligned(8)));
+static uint8 ide_async_buffer[IDE_ASYNC_MAX_SECTS * SECTSIZE] __attribute__((aligned(IDE_ASYNC_MAX_SECTS * SECTSIZE)));
+static uint32 ide_async_nsecs;
+
+static uint32 pci_config_read(uint32 bus, uint32 dev, uint32 func, uint32 reg)
+{
+	outl(PCI_CONFIG_ADDR, 0x80000000 | (bus << 16) | (dev << 11) | (func << 8) | (reg & 0xFC));
+	return inl(PCI_CONFIG_DATA);
+}
+
+static void pci_config_write(uint32 bus, uint32 dev, uint32 func, uint32 reg, uint32 value)
+{
+	outl(PCI_CONFIG_ADDR, 0x80000000 | (bus << 16) | (dev << 11) | (func << 8) | (reg & 0xFC));
+	outl(PCI_CONFIG_DATA, value);
+}
+
+//Looks for a bus-master capable PCI IDE controller on bus 0 and enables DMA on it.
+//Returns 1 if found (DMA is then used by ide_read()/ide_write()), 0 otherwise (PIO only)
+int ide_dma_init()
+{
+	uint32 dev, func;
+
+	ide_dma_enabled = 0;
+	ide_bm_base = 0;
+	for (dev = 0; dev < 32; dev++)
+	{
+		for (func = 0; func < 8; func++)
+		{
+			uint32 id = pci_config_read(0, dev, func, 0x00);
+			if ((id & 0xFFFF) == 0xFFFF)
+				continue;
+
+			uint32 class = pci_config_read(0, dev, func, 0x08);
+			if ((class >> 24) != PCI_CLASS_STORAGE || ((class >> 16) & 0xFF) != PCI_SUBCLASS_IDE
+					|| (((class >> 8) & 0xFF) & PCI_IDE_PROGIF_BM) == 0)
+				continue;
+
+			uint32 bar4 = pci_config_read(0, dev, func, 0x20);
+			if ((bar4 & 1) == 0 || (bar4 & 0xFFFC) == 0)
+				continue;
+
+			uint32 cmd = pci_config_read(0, dev, func, 0x04);
+			pci_config_write(0, dev, func, 0x04, cmd | PCI_CMD_IO | PCI_CMD_BUS_MASTER);
+
+			ide_bm_base = bar4 & 0xFFFC;
+			ide_dma_enabled = 1;
+			cprintf("IDE: bus-master DMA (PCI %x:%x, vendor %x device %x, I/O %x)\n",
+					dev, func, id & 0xFFFF, id >> 16, ide_bm_base);
+			return 1;
+		}
+	}
+	cprintf("IDE: no bus-master controller found, using PIO\n");
+	return 0;
+}
+
+//Turns DMA on/off (it can't be turned on if no controller was found). Returns the new state
+uint32 ide_dma_set(uint32 enable)
+{
+	ide_dma_enabled = (enable && ide_bm_base != 0) ? 1 : 0;
+	return ide_dma_enabled;
+}
+
+//Starts a READ/WRITE DMA command of nsecs sectors from/to the given physically contiguous region.
+//The disk should be on the primary channel
+static void ide_dma_start(uint32 disk, struct PRD* prd_table, uint8* buffer, uint32 secno, uint32 nsecs, bool isWrite)
+{
+	ide_wait_ready(0x1F0, 0);
+
+	prd_table[0].physical_address = (uint32)buffer - KERNEL_BASE;
+	prd_table[0].byte_count = (uint16)(nsecs * SECTSIZE);	//64 KB is written as 0
+	prd_table[0].flags = PRD_EOT;
+
+	outb(ide_bm_base + BM_CMD, 0);
+	outl(ide_bm_base + BM_PRDT, (uint32)prd_table - KERNEL_BASE);
+	outb(ide_bm_base + BM_CMD, isWrite ? 0 : BM_CMD_READ);
+	//clear the ERR and IRQ bits (write 1 to clear)
+	outb(ide_bm_base + BM_STATUS, inb(ide_bm_base + BM_STATUS) | BM_STATUS_ERR | BM_STATUS_IRQ);
+
+	ide_command(disk, secno, nsecs, isWrite ? IDE_CMD_WRITE_DMA : IDE_CMD_READ_DMA);
+
+	outb(ide_bm_base + BM_CMD, (isWrite ? 0 : BM_CMD_READ) | BM_CMD_START);
+}
+
+//Polls the bus-master status for the completion of the started DMA command
+static int ide_dma_wait()
+{
+	uint8 status = 0;
+	int i;
+
+	for (i = 0; i < IDE_DMA_TIMEOUT; i++)
+	{
+		status = inb(ide_bm_base + BM_STATUS);
+		if ((status & (BM_STATUS_IRQ | BM_STATUS_ERR)) != 0 && (status & BM_STATUS_ACTIVE) == 0)
+			break;
+		if (status & BM_STATUS_ERR)
+			break;
+	}
+
+	outb(ide_bm_base + BM_CMD, 0);
+	outb(ide_bm_base + BM_STATUS, status | BM_STATUS_ERR | BM_STATUS_IRQ);
+
+	//reading the ATA status also acknowledges the drive's interrupt
+	uint8 ata_status = inb(0x1F7);
+	if (i == IDE_DMA_TIMEOUT || (status & BM_STATUS_ERR) || (ata_status & (IDE_DF|IDE_ERR)) != 0)
+	{
+		LOG_STATMENT(cprintf("ERROR @ ide_dma_wait() bm status = %x, ata status = %x\n", status, ata_status););
+		return -1;
+	}
+	return 0;
+}
+
+//Issues one READ/WRITE DMA command of at most IDE_DMA_BOUNCE_SECTS sectors through the bounce buffer
+//and waits for its completion
+static int ide_dma_command(uint32 disk, uint32 secno, uint32 nsecs, bool isWrite)
+{
+	ide_dma_start(disk, ide_prd_table, ide_dma_bounce, secno, nsecs, isWrite);
+	return ide_dma_wait();
+}
+
+//Transfers nsecs sectors between the disk and buf by DMA, in chunks of the bounce buffer size.
+//On error, DMA is turned off and -1 is returned so that the caller falls back to PIO
+static int ide_dma_transfer(uint32 disk, uint32 secno, void *buf, uint32 nsecs, bool isWrite)
+{
+	while (nsecs > 0)
+	{
+		uint32 n = nsecs < IDE_DMA_BOUNCE_SECTS ? nsecs : IDE_DMA_BOUNCE_SECTS;
+		if (isWrite)
+			memcpy(ide_dma_bounce, buf, n * SECTSIZE);
+		if (ide_dma_command(disk, secno, n, isWrite) < 0)
+		{
+			cprintf("IDE: DMA transfer failed, falling back to PIO\n");
+			ide_dma_enabled = 0;
+			return -1;
+		}
+		if (!isWrite)
+			memcpy(buf, ide_dma_bounce, n * SECTSIZE);
+
+		secno += n;
+		buf += n * SECTSIZE;
+		nsecs -= n;
+	}
+	return 0;
+}
+
+//==================================================================================//
+//=================== 2026: ASYNCHRONOUS (IRQ14 DRIVEN) DMA READ ===================//
+//==================================================================================//
+//Only one asynchronous read can be in flight. Its completion is signaled by IRQ14 and
+//detected by ide_async_poll(), then its data is taken by ide_async_collect().
+
+//Starts reading nsecs (<= IDE_ASYNC_MAX_SECTS) sectors into the asynchronous buffer and returns
+//immediately. Returns 0 on success, -1 if DMA is unavailable or another asynchronous read is pending
+int ide_read_async(uint32 secno, uint32 nsecs)
+{
+	if (!ide_dma_enabled || ide_async_state != IDE_ASYNC_IDLE || nsecs > IDE_ASYNC_MAX_SECTS)
+		return -1;
+
+	ide_async_nsecs = nsecs;
+	ide_async_state = IDE_ASYNC_BUSY;
+	ide_dma_start(diskno, ide_async_prd_table, ide_async_buffer, secno, nsecs, 0);
+	return 0;
+}
+
+//Checks (or waits, if "wait" is set) for the completion of the asynchronous read.
+//Returns the new state (IDE_ASYNC_BUSY if still in progress)
+uint32 ide_async_poll(bool wait)
+{
+	uint8 status = 0;
+	int i;
+
+	if (ide_async_state != IDE_ASYNC_BUSY)
+		return ide_async_state;
+
+	for (i = 0; i < IDE_DMA_TIMEOUT; i++)
+	{
+		status = inb(ide_bm_base + BM_STATUS);
+		if ((status & BM_STATUS_ERR) || ((status & BM_STATUS_IRQ) && (status & BM_STATUS_ACTIVE) == 0))
+			break;
+		if (!wait)
+			return IDE_ASYNC_BUSY;
+	}
+
+	outb(ide_bm_base + BM_CMD, 0);
+	outb(ide_bm_base + BM_STATUS, status | BM_STATUS_ERR | BM_STATUS_IRQ);
+	uint8 ata_status = inb(0x1F7);
+	if (i == IDE_DMA_TIMEOUT || (status & BM_STATUS_ERR) || (ata_status & (IDE_DF|IDE_ERR)) != 0)
+	{
+		LOG_STATMENT(cprintf("ERROR @ ide_async_poll() bm status = %x, ata status = %x\n", status, ata_status););
+		ide_async_state = IDE_ASYNC_ERROR;
+	}
+	else
+	{
+		ide_async_state = IDE_ASYNC_DONE;
+	}
+	return ide_async_state;
+}
+
+//Copies the data of the completed asynchronous read to dst (dropped if dst is NULL)
+//and frees the channel for the next one. Returns 0 on success, -1 on read error or if not completed
+int ide_async_collect(void *dst)
+{
+	int ret = 0;
+	if (ide_async_state == IDE_ASYNC_DONE)
+	{
+		if (dst != NULL)
+			memcpy(dst, ide_async_buffer, ide_async_nsecs * SECTSIZE);
+	}
+	else if (ide_async_state == IDE_ASYNC_ERROR)
+	{
+		ret = -1;
+	}
+	else
+	{
+		return -1;
+	}
+	ide_async_state = IDE_ASYNC_IDLE;
+	return ret;
+}
+
+//==================================================================================//
+//================== 2026: CONCURRENT TRANSFERS ON BOTH CHANNELS ===================//
+//==================================================================================//
+
+int ide_transfer(struct IdeTransfer* t)
+{
+	if (t->isWrite)
+		return ide_write_disk(t->disk, t->secno, t->buf, t->nsecs);
+	return ide_read_disk(t->disk, t->secno, t->buf, t->nsecs);
+}
+
+//Runs both transfers at the same time if their disks are on different channels (one after the
+//other otherwise): both commands are issued first, then the PIO data of whichever channel is ready
+//is moved. The primary channel one runs by DMA if possible. Returns 0, or -1 if any of them failed
+int ide_transfer_pair(struct IdeTransfer* a, struct IdeTransfer* b)
+{
+	struct IdeTransfer* xfers[2] = {a, b};
+	uint32 left[2];
+	uint8* buf[2];
+	int ret = 0, dma = -1, i, r;
+
+	if (IDE_CHANNEL(a->disk) == IDE_CHANNEL(b->disk))
+	{
+		ret = ide_transfer(a);
+		r = ide_transfer(b);
+		return ret != 0 ? ret : r;
+	}
+
+	//[1] start both commands
+	for (i = 0; i < 2; i++)
+	{
+		struct IdeTransfer* t = xfers[i];
+		assert(t->nsecs <= ide_max_sectors(t->disk));
+		left[i] = t->nsecs;
+		buf[i] = t->buf;
+		if (IDE_CHANNEL(t->disk) == 0)
+		{
+			if (ide_async_state == IDE_ASYNC_BUSY)
+				ide_async_poll(1);
+			if (ide_dma_enabled && t->nsecs <= IDE_DMA_BOUNCE_SECTS)
+			{
+				if (t->isWrite)
+					memcpy(ide_dma_bounce, t->buf, t->nsecs * SECTSIZE);
+				ide_dma_start(t->disk, ide_prd_table, ide_dma_bounce, t->secno, t->nsecs, t->isWrite);
+				dma = i;
+				left[i] = 0;
+				continue;
+			}
+		}
+		ide_wait_ready(IDE_IOBASE(t->disk), 0);
+		ide_command(t->disk, t->secno, t->nsecs, t->isWrite ? IDE_CMD_WRITE : IDE_CMD_READ);
+	}
+
+	//[2] move the PIO sectors as each channel gets ready
+	while (left[0] > 0 || left[1] > 0)
+	{
+		for (i = 0; i < 2; i++)
+		{
+			if (left[i] == 0)
+				continue;
+			uint16 iobase = IDE_IOBASE(xfers[i]->disk);
+			r = inb(iobase + 7);
+			if (r & IDE_BSY)
+				continue;
+			if (r & (IDE_DF|IDE_ERR))
+			{
+				LOG_STATMENT(cprintf("ERROR @ ide_transfer_pair() disk %d status = %x\n", xfers[i]->disk, r););
+				ret = -1;
+				left[i] = 0;
+				continue;
+			}
+			if ((r & IDE_DRQ) == 0)
+				continue;
+			if (xfers[i]->isWrite)
+				outsl(iobase, buf[i], SECTSIZE/4);
+			else
+				insl(iobase, buf[i], SECTSIZE/4);
+			buf[i] += SECTSIZE;
+			left[i]--;
+		}
+	}
+
+	//[3] wait for the DMA one (redone by PIO if it failed)
+	if (dma >= 0)
+	{
+		struct IdeTransfer* t = xfers[dma];
+		if (ide_dma_wait() < 0)
+		{
+			cprintf("IDE: DMA transfer failed, falling back to PIO\n");
+			ide_dma_enabled = 0;
+			if (ide_transfer(t) != 0)
+				ret = -1;
+		}
+		else if (!t->isWrite)
+		{
+			memcpy(t->buf, ide_dma_bounce, t->nsecs * SECTSIZE);
+		}
+	}
+	return ret;
+}
@@ -144,3 +144,28 @@ void *realloc(void *virtual_address, uint32 new_size)
 
 	return NULL;
 }
+
+//===============
+// 2026: memory hints
+//===============
+
+//	Tells the kernel how the range [virtual_address, virtual_address + size) will be accessed:
+//	MADV_SEQUENTIAL reads ahead on each fault inside the range, MADV_RANDOM/MADV_NORMAL don't,
+//	MADV_WILLNEED loads the range now and MADV_DONTNEED removes it from the working set now.
+//	Returns 0 on success or a negative error code.
+int madvise(void* virtual_address, uint32 size, int advice)
+{
+	return sys_madvise((uint32)virtual_address, size, advice);
+}
+
+//	Keeps the pages of the given range resident in memory until munlock() or free().
+//	At most half of the working set can be locked (E_NO_MEM otherwise).
+int mlock(void* virtual_address, uint32 size)
+{
+	return sys_mlock((uint32)virtual_address, size);
+}
+
+int munlock(void* virtual_address, uint32 size)
+{
+	return sys_munlock((uint32)virtual_address, size);
+}
@@ -0,0 +1,132 @@
+/*
+ * mkprogstore: packs the FOS user programs into the program store of the disk image.
+ *
+ * The store (see kern/program_store.h, the structures below must match it) is:
+ *	- an index of PS_INDEX_SECTORS sectors: a header (magic, # programs, # sectors of the store)
+ *	  then one entry per program (name, first sector from the start of the store, size in bytes)
+ *	- the ELF image of each program, starting on a sector boundary
+ * The name of a program is the filename of its image (e.g. obj/user/fos_add => fos_add).
+ *
+ * Usage: mkprogstore <store file> <program image> ...
+ *
+ * This is a HOST program: it's run by the build to write the store on the disk image.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define SECTSIZE			512
+#define PS_INDEX_SECTORS	16
+#define PS_MAGIC			0x53475046
+#define PS_NAME_LEN			56
+
+struct ProgramStoreEntry
+{
+	char name[PS_NAME_LEN];
+	uint32_t sector;
+	uint32_t size;
+};
+
+struct ProgramStoreHeader
+{
+	uint32_t magic;
+	uint32_t count;
+	uint32_t nsectors;
+	uint8_t reserved[sizeof(struct ProgramStoreEntry) - 3 * sizeof(uint32_t)];
+};
+
+#define PS_MAX_PROGRAMS		(PS_INDEX_SECTORS * SECTSIZE / sizeof(struct ProgramStoreEntry) - 1)
+
+static union
+{
+	struct ProgramStoreHeader header;
+	struct ProgramStoreEntry entries[PS_MAX_PROGRAMS + 1];
+} ps_index;
+
+//Appends the given file to the store, padded to a sector boundary. Returns its size, or -1 on error
+static long append_image(FILE *store, const char *path)
+{
+	static char zeros[SECTSIZE];
+	char buf[4096];
+	size_t n;
+	long size = 0;
+	FILE *f = fopen(path, "rb");
+
+	if (f == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+	{
+		fwrite(buf, 1, n, store);
+		size += n;
+	}
+	fclose(f);
+	if (size % SECTSIZE != 0)
+		fwrite(zeros, 1, SECTSIZE - size % SECTSIZE, store);
+	return size;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t sector = PS_INDEX_SECTORS;
+	FILE *store;
+	int i;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <store file> <program image> ...\n", argv[0]);
+		return 1;
+	}
+	if (argc - 2 > PS_MAX_PROGRAMS)
+	{
+		fprintf(stderr, "%s: too many programs (max %d)\n", argv[0], (int)PS_MAX_PROGRAMS);
+		return 1;
+	}
+
+	store = fopen(argv[1], "wb");
+	if (store == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+	//the index is written last, once the images are placed
+	fseek(store, PS_INDEX_SECTORS * SECTSIZE, SEEK_SET);
+
+	for (i = 2; i < argc; i++)
+	{
+		struct ProgramStoreEntry *entry = &ps_index.entries[i - 1];
+		const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+		long size;
+
+		if (strlen(name) >= PS_NAME_LEN)
+		{
+			fprintf(stderr, "%s: program name too long: %s\n", argv[0], name);
+			goto error;
+		}
+		size = append_image(store, argv[i]);
+		if (size < 0)
+			goto error;
+
+		strcpy(entry->name, name);
+		entry->sector = sector;
+		entry->size = size;
+		sector += (size + SECTSIZE - 1) / SECTSIZE;
+	}
+
+	ps_index.header.magic = PS_MAGIC;
+	ps_index.header.count = argc - 2;
+	ps_index.header.nsectors = sector;
+	fseek(store, 0, SEEK_SET);
+	fwrite(&ps_index, 1, sizeof(ps_index), store);
+	fclose(store);
+	return 0;
+
+error:
+	fclose(store);
+	remove(argv[1]);
+	return 1;
+}
@@ -0,0 +1,372 @@
+/*
+ * pgreplay: replays a FOS page-reference trace under several page replacement algorithms.
+ *
+ * The trace is the text written to the serial port by the "pgtracedump" command (see kern/pgtrace.h):
+ *	#FOSTRACE <# records> <# dropped records>
+ *	#ENV <env id> <program name> <WS size>
+ *	<F|U> <env id> <tick> <va> <write>
+ *
+ * Each env is replayed alone (FOS replaces pages locally, in the WS of the faulted env).
+ * The reference string of an env is rebuilt from its records in order: each fault (F) and each
+ * page found USED at a tick (U) is one reference. A reference is a write if the faulting access was
+ * a write, or if a sample finds the page MODIFIED while it was still clean since its last fault.
+ * Since the samples are per tick, the order of the references inside a tick is approximated.
+ *
+ * Usage: pgreplay <trace file | -> [-e <env id>] [WS size ...]
+ *	(the WS size of the env recorded in the trace is used if no size is given)
+ *
+ * This is a HOST program: build it with "make pgreplay".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Ref
+{
+	unsigned va;
+	int write;
+	int page;		//index of the page in pages[]
+};
+
+struct TraceEnv
+{
+	int id;
+	char name[64];
+	unsigned wsSize;
+};
+
+static struct Ref *refs;
+static int nRefs, capRefs;
+
+//distinct pages of the replayed env
+static struct
+{
+	unsigned va;
+	int dirty;		//written since its last fault in the trace
+	int lastRef;
+} *pages;
+static int nPages, capPages;
+
+static struct TraceEnv envs[256];
+static int nEnvs;
+
+//all trace records (kept to split them per env)
+static struct
+{
+	char type;
+	int env;
+	unsigned va;
+	int write;
+} *records;
+static int nRecords, capRecords;
+
+//========================== simulation of a WS ==========================
+
+struct Frame
+{
+	unsigned va;
+	int used;
+	int modified;
+	unsigned long stamp;	//load time (FIFO) or last reference time (LRU)
+	int nextRef;			//index of the next reference of the page (OPT)
+};
+
+struct Result
+{
+	unsigned long faults;
+	unsigned long writeBacks;
+};
+
+enum Policy { FIFO, CLOCK, MODIFIED_CLOCK, LRU, OPT, NPOLICIES };
+static const char *policyNames[NPOLICIES] = { "FIFO", "CLOCK", "modCLOCK", "LRU", "OPT" };
+
+static int *nextUse;	//index of the next reference of the same page (nRefs if none), for OPT
+
+static int find_frame(struct Frame *ws, int size, unsigned va)
+{
+	int i;
+	for (i = 0; i < size; i++)
+		if (ws[i].va == va)
+			return i;
+	return -1;
+}
+
+//Selects the victim among the (full) WS according to the policy.
+//"hand" is the clock hand / last WS index (as env->page_last_WS_index in the kernel)
+static int select_victim(enum Policy policy, struct Frame *ws, int size, int *hand)
+{
+	int i, victim = 0;
+
+	switch (policy)
+	{
+	case FIFO:
+	case LRU:
+		for (i = 1; i < size; i++)
+			if (ws[i].stamp < ws[victim].stamp)
+				victim = i;
+		return victim;
+
+	case CLOCK:
+		for (;;)
+		{
+			if (!ws[*hand].used)
+				return *hand;
+			ws[*hand].used = 0;
+			*hand = (*hand + 1) % size;
+		}
+
+	case MODIFIED_CLOCK:
+		//same two scans as page_fault_handler() in kern/trap.c
+		for (;;)
+		{
+			for (i = 0; i < size; i++)
+			{
+				int k = (*hand + i) % size;
+				if (!ws[k].used && !ws[k].modified)
+					return k;
+			}
+			for (i = 0; i < size; i++)
+			{
+				int k = (*hand + i) % size;
+				if (!ws[k].used)
+					return k;
+				ws[k].used = 0;
+			}
+		}
+
+	case OPT:
+		//the page whose next reference is the farthest in the future
+		for (i = 1; i < size; i++)
+			if (ws[i].nextRef > ws[victim].nextRef)
+				victim = i;
+		return victim;
+
+	default:
+		return 0;
+	}
+}
+
+static struct Result simulate(enum Policy policy, int size)
+{
+	struct Result res = { 0, 0 };
+	struct Frame *ws = calloc(size, sizeof(struct Frame));
+	int nLoaded = 0, hand = 0;
+	int r;
+
+	for (r = 0; r < nRefs; r++)
+	{
+		unsigned va = refs[r].va;
+		int idx = find_frame(ws, nLoaded, va);
+
+		if (idx < 0)
+		{
+			res.faults++;
+			if (nLoaded < size)
+			{
+				idx = nLoaded++;
+			}
+			else
+			{
+				idx = select_victim(policy, ws, size, &hand);
+				if (ws[idx].modified)
+					res.writeBacks++;
+				hand = (idx + 1) % size;
+			}
+			ws[idx].va = va;
+			ws[idx].modified = 0;
+			ws[idx].stamp = r;
+		}
+		ws[idx].used = 1;
+		if (refs[r].write)
+			ws[idx].modified = 1;
+		if (policy == LRU)
+			ws[idx].stamp = r;
+		ws[idx].nextRef = nextUse[r];
+	}
+	free(ws);
+	return res;
+}
+
+//========================== trace loading ==========================
+
+static int find_page(unsigned va)
+{
+	int i;
+	for (i = 0; i < nPages; i++)
+		if (pages[i].va == va)
+			return i;
+	if (nPages == capPages)
+	{
+		capPages = capPages ? capPages * 2 : 256;
+		pages = realloc(pages, capPages * sizeof(*pages));
+	}
+	pages[nPages].va = va;
+	pages[nPages].dirty = 0;
+	return nPages++;
+}
+
+static void add_ref(unsigned va, int write, int page)
+{
+	if (nRefs == capRefs)
+	{
+		capRefs = capRefs ? capRefs * 2 : 4096;
+		refs = realloc(refs, capRefs * sizeof(struct Ref));
+	}
+	refs[nRefs].va = va;
+	refs[nRefs].write = write;
+	refs[nRefs].page = page;
+	nRefs++;
+}
+
+static void load_trace(FILE *f)
+{
+	char line[256];
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		char type;
+		int env, tick, write;
+		unsigned va;
+
+		if (strncmp(line, "#ENV", 4) == 0 && nEnvs < 256)
+		{
+			struct TraceEnv *e = &envs[nEnvs];
+			if (sscanf(line, "#ENV %d %63s %u", &e->id, e->name, &e->wsSize) == 3)
+				nEnvs++;
+			continue;
+		}
+		if (sscanf(line, " %c %d %d %x %d", &type, &env, &tick, &va, &write) != 5 || (type != 'F' && type != 'U'))
+			continue;
+
+		if (nRecords == capRecords)
+		{
+			capRecords = capRecords ? capRecords * 2 : 4096;
+			records = realloc(records, capRecords * sizeof(*records));
+		}
+		records[nRecords].type = type;
+		records[nRecords].env = env;
+		records[nRecords].va = va;
+		records[nRecords].write = write;
+		nRecords++;
+	}
+}
+
+//Builds the reference string of the given env (see the header comment)
+static void build_refs(int env)
+{
+	int i;
+
+	nRefs = 0;
+	nPages = 0;
+	for (i = 0; i < nRecords; i++)
+	{
+		int page, write = records[i].write;
+		if (records[i].env != env)
+			continue;
+
+		page = find_page(records[i].va);
+		if (records[i].type == 'F')
+		{
+			//loaded again from the page file: clean
+			pages[page].dirty = write;
+		}
+		else if (write)
+		{
+			//MODIFIED stays set until the page is removed: count the first sample only
+			write = !pages[page].dirty;
+			pages[page].dirty = 1;
+		}
+		add_ref(records[i].va, write, page);
+	}
+
+	free(nextUse);
+	nextUse = malloc((nRefs + 1) * sizeof(int));
+	for (i = 0; i < nPages; i++)
+		pages[i].lastRef = nRefs;
+	for (i = nRefs - 1; i >= 0; i--)
+	{
+		nextUse[i] = pages[refs[i].page].lastRef;
+		pages[refs[i].page].lastRef = i;
+	}
+}
+
+static void replay_env(struct TraceEnv *e, unsigned *sizes, int nSizes)
+{
+	int s, p;
+
+	build_refs(e->id);
+	printf("env %d (%s): %d references\n", e->id, e->name, nRefs);
+	if (nRefs == 0)
+		return;
+
+	printf("  %8s", "WS size");
+	for (p = 0; p < NPOLICIES; p++)
+		printf(" | %8s faults  w-backs", policyNames[p]);
+	printf("\n");
+
+	for (s = 0; s < (nSizes ? nSizes : 1); s++)
+	{
+		int size = nSizes ? sizes[s] : e->wsSize;
+		if (size <= 0)
+			continue;
+		printf("  %8d", size);
+		for (p = 0; p < NPOLICIES; p++)
+		{
+			struct Result res = simulate(p, size);
+			printf(" | %15lu %8lu", res.faults, res.writeBacks);
+		}
+		printf("\n");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned sizes[64];
+	int nSizes = 0, envFilter = 0, i;
+	FILE *f;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <trace file | -> [-e <env id>] [WS size ...]\n", argv[0]);
+		return 1;
+	}
+	for (i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+			envFilter = atoi(argv[++i]);
+		else if (nSizes < 64)
+			sizes[nSizes++] = atoi(argv[i]);
+	}
+
+	f = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+	if (f == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+	load_trace(f);
+	if (f != stdin)
+		fclose(f);
+
+	//envs recorded without a #ENV line (e.g. more than the kernel reports)
+	for (i = 0; i < nRecords; i++)
+	{
+		int k;
+		for (k = 0; k < nEnvs && envs[k].id != records[i].env; k++)
+			;
+		if (k == nEnvs && nEnvs < 256)
+		{
+			envs[nEnvs].id = records[i].env;
+			strcpy(envs[nEnvs].name, "?");
+			envs[nEnvs].wsSize = 0;
+			nEnvs++;
+		}
+	}
+
+	for (i = 0; i < nEnvs; i++)
+	{
+		if (envFilter == 0 || envs[i].id == envFilter)
+			replay_env(&envs[i], sizes, nSizes);
+	}
+	return 0;
+}
@@ -0,0 +1,54 @@
+// Scenario that tests running, exiting and reaping several envs (sys_run_env, exit, sys_waitenv)
+#include <inc/lib.h>
+
+void _main(void)
+{
+	struct EnvExitInfo info;
+	int freeFrames_before = sys_calculate_free_frames() ;
+
+	//Create & run 3 children (in different slots of envs[])
+	int32 envIdA = sys_create_env("fos_helloWorld", 10, 50);
+	int32 envIdB = sys_create_env("fos_add", 20, 50);
+	int32 envIdC = sys_create_env("fos_helloWorld", 10, 50);
+	if (envIdA <= 0 || envIdB <= 0 || envIdC <= 0)
+		panic("sys_create_env() failed");
+	if (ENVX(envIdA) == ENVX(envIdB) || ENVX(envIdB) == ENVX(envIdC) || ENVX(envIdA) == ENVX(envIdC))
+		panic("the children should have different slots");
+
+	sys_run_env(envIdA);
+	sys_run_env(envIdB);
+	sys_run_env(envIdC);
+
+	//[1] reap a given child
+	int32 ret = sys_waitenv(envIdB, &info);
+	if (ret != envIdB || info.envId != envIdB)
+		panic("sys_waitenv(B) returned %d (info.envId = %d) instead of %d", ret, info.envId, envIdB);
+	if (info.exitStatus != 0)
+		panic("wrong exit status of B: %d", info.exitStatus);
+
+	//[2] reap the others in any order
+	int32 first = sys_waitenv(ANY_CHILD, &info);
+	int32 second = sys_waitenv(ANY_CHILD, NULL);
+	if (!((first == envIdA && second == envIdC) || (first == envIdC && second == envIdA)))
+		panic("sys_waitenv(ANY_CHILD) returned %d then %d instead of %d & %d", first, second, envIdA, envIdC);
+
+	//[3] no more children
+	if (sys_waitenv(ANY_CHILD, NULL) != E_BAD_ENV)
+		panic("sys_waitenv() should fail when there's no more children");
+	if (sys_waitenv(envIdA, NULL) != E_BAD_ENV)
+		panic("a child should be reaped only once");
+
+	//[4] a kernel address isn't accepted for the info
+	int32 envIdD = sys_create_env("fos_helloWorld", 10, 50);
+	sys_run_env(envIdD);
+	if (sys_waitenv(envIdD, (struct EnvExitInfo*)USER_TOP) != E_INVAL)
+		panic("sys_waitenv() should reject an info outside the user space");
+	if (sys_waitenv(envIdD, &info) != envIdD)
+		panic("sys_waitenv(D) failed");
+
+	if (sys_calculate_free_frames() != freeFrames_before)
+		panic("the reaped children should be freed: %d frames lost", freeFrames_before - sys_calculate_free_frames());
+
+	cprintf("\nCongratulations!! test of running, exiting & reaping envs completed successfully.\n");
+	return;
+}